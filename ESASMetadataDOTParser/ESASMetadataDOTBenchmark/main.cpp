@@ -0,0 +1,487 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "EDM.h"
+#include "Generator.h"
+#include "Graph.h"
+#include "IncrementalReader.h"
+#include "IncrementalWriter.h"
+#include "JsonString.h"
+#include "tinyxml2.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fplus/stopwatch.hpp>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace tinyxml2;
+
+/**
+ * Benchmark suite for the whole pipeline.
+ *
+ * Every input is run <runs> times through XMLDocument::Parse, Graph::visit,
+ * Graph::resolve, create_arrows and print_graph for the full diagram, and
+ * through removeAllEntitiesNotRelatedTo, create_arrows and print_graph for a
+ * hub, a median and a leaf entity as center at depths 1, 2 and 3. Each phase
+ * reports the median and 95th percentile wall time and the median number of
+ * heap allocations.
+ *
+ * Every input is also run through the --watch pipeline with a property
+ * renamed and back again; the patched diagram has to be the same as a
+ * fresh render, or the tool fails.
+ *
+ * With --kernels the tool instead compares the tinyxml2 scanning kernels on
+ * a scaled up copy of one file.
+ */
+
+// Heap allocation counter, for allocations per phase. GCC cannot tell that
+// the replacement new below is malloc based and flags the free() calls --
+
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static atomic<size_t> allocations{0};
+
+void *operator new( size_t size ) {
+    ++allocations;
+    if ( void *memory = malloc( size > 0 ? size : 1 ) ) {
+        return memory;
+    }
+    throw bad_alloc{};
+}
+
+void operator delete( void *memory ) noexcept {
+    free( memory );
+}
+
+void operator delete( void *memory, size_t ) noexcept {
+    operator delete( memory );
+}
+
+void *operator new[]( size_t size ) {
+    return operator new( size );
+}
+
+void operator delete[]( void *memory ) noexcept {
+    operator delete( memory );
+}
+
+void operator delete[]( void *memory, size_t ) noexcept {
+    operator delete( memory );
+}
+
+/**
+ * Helpers
+ */
+
+// Discards everything written to it, so printing is timed without I/O --
+class NullBuffer : public streambuf {
+  protected:
+    int overflow( int c ) override { return c; }
+    streamsize xsputn( const char *, streamsize count ) override { return count; }
+};
+
+struct Phase {
+    string name;
+    vector<double> seconds;
+    vector<size_t> allocations;
+};
+
+struct Result {
+    string input;
+    size_t bytes = 0;
+    size_t entities = 0;
+    size_t edges = 0;
+    vector<Phase> phases;
+
+    template <typename Function>
+    void measure( const string &name, Function &&function ) {
+        auto phase = find_if( phases.begin(), phases.end(), [&]( const Phase &p ) { return p.name == name; } );
+        if ( phase == phases.end() ) {
+            phases.push_back( {name, {}, {}} );
+            phase = phases.end() - 1;
+        }
+        size_t before = allocations;
+        fplus::stopwatch timer;
+        function();
+        phase->seconds.push_back( timer.elapsed() );
+        phase->allocations.push_back( allocations - before );
+    }
+};
+
+template <typename T>
+T percentile( vector<T> values, double fraction ) {
+    sort( values.begin(), values.end() );
+    size_t index = static_cast<size_t>( fraction * static_cast<double>( values.size() - 1 ) + 0.5 );
+    return values[min( index, values.size() - 1 )];
+}
+
+string read_file( const string &fileName ) {
+    ifstream file( fileName, ios::binary );
+    ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+string scale_document( const string &xml, int scale ) {
+    auto first = xml.find( "<EntityType" );
+    auto last = xml.rfind( "</EntityType>" );
+    if ( first == string::npos || last == string::npos || scale <= 1 ) {
+        return xml;
+    }
+    last += string{"</EntityType>"}.size();
+
+    string scaled;
+    scaled.reserve( xml.size() + ( last - first ) * static_cast<size_t>( scale - 1 ) );
+    scaled.append( xml, 0, first );
+    for ( int i = 0; i < scale; ++i ) {
+        scaled.append( xml, first, last - first );
+    }
+    scaled.append( xml, last, string::npos );
+    return scaled;
+}
+
+double median_parse_seconds( const string &xml, int runs ) {
+    vector<double> times;
+    for ( int i = 0; i < runs; ++i ) {
+        XMLDocument doc;
+        doc.SetNameClassifier( classify_edm_name );
+        fplus::stopwatch timer;
+        doc.Parse( xml.data(), xml.size() );
+        times.push_back( timer.elapsed() );
+        if ( doc.Error() ) {
+            cout << "Parse error: " << doc.ErrorStr() << endl;
+            return 0;
+        }
+    }
+    sort( times.begin(), times.end() );
+    return times[times.size() / 2];
+}
+
+/**
+ * Input specs are file names, or gen:<entities>[:powerlaw] for a document
+ * from the generator with seed 1.
+ */
+string load_input( const string &spec ) {
+    if ( spec.rfind( "gen:", 0 ) != 0 ) {
+        return read_file( spec );
+    }
+
+    GeneratorOptions options;
+    options.entities = max<size_t>( 1, strtoull( spec.c_str() + 4, nullptr, 10 ) );
+    options.powerLaw = spec.find( ":powerlaw" ) != string::npos;
+    options.schemas = options.entities >= 10000 ? 4 : 1;
+
+    FILE *file = tmpfile();
+    if ( file == nullptr || !generate_metadata( options, file ) ) {
+        return {};
+    }
+    string xml( static_cast<size_t>( ftell( file ) ), '\0' );
+    rewind( file );
+    xml.resize( fread( xml.data(), 1, xml.size(), file ) );
+    fclose( file );
+    return xml;
+}
+
+/**
+ * Hub, median and leaf by degree, picked once from a parsed graph.
+ */
+vector<string> pick_centers( Graph &graph ) {
+    const auto &adjacency = graph.adjacency();
+    const auto &model = graph.model();
+
+    vector<pair<size_t, uint32_t>> degrees;
+    for ( uint32_t node = 0; node < adjacency.node_count(); ++node ) {
+        if ( adjacency.entities( node ).size() > 0 ) {
+            degrees.emplace_back( adjacency.out( node ).size() + adjacency.in( node ).size(), node );
+        }
+    }
+    if ( degrees.empty() ) {
+        return {};
+    }
+    sort( degrees.begin(), degrees.end() );
+
+    vector<string> centers;
+    for ( size_t index : {degrees.size() - 1, degrees.size() / 2, size_t{0}} ) {
+        centers.emplace_back( model.strings[adjacency.name( degrees[index].second )] );
+    }
+    return centers;
+}
+
+Result run_input( const string &spec, const string &xml, int runs, unsigned threads ) {
+    Result result;
+    result.input = spec;
+    result.bytes = xml.size();
+
+    NullBuffer nullBuffer;
+    ostream sink( &nullBuffer );
+    vector<string> centers;
+
+    for ( int run = 0; run < runs; ++run ) {
+        auto doc = make_shared<XMLDocument>();
+        doc->SetNameClassifier( classify_edm_name );
+        Graph graph;
+
+        result.measure( "parse", [&]() { doc->Parse( xml.data(), xml.size() ); } );
+        if ( doc->Error() ) {
+            cout << spec << ": parse error: " << doc->ErrorStr() << endl;
+            return result;
+        }
+        graph.borrow_from( doc );
+        result.measure( "visit", [&]() { graph.visit( doc.get() ); } );
+        result.measure( "resolve", [&]() { graph.resolve(); } );
+        result.measure( "arrows", [&]() { graph.create_arrows(); } );
+        result.measure( "print", [&]() { graph.print_graph( sink ); } );
+        result.measure( "print:threads", [&]() { graph.print_graph( sink, threads ); } );
+
+        if ( run == 0 ) {
+            centers = pick_centers( graph );
+            result.entities = graph.model().entity_count();
+            result.edges = graph.model().edge_count();
+        }
+
+        // Phases at depth 1 keep their plain names, deeper ones get the depth appended --
+
+        const char *roles[] = {"hub", "median", "leaf"};
+        for ( unsigned depth : {1u, 2u, 3u} ) {
+            for ( size_t i = 0; i < centers.size(); ++i ) {
+                string suffix = string{":"} + roles[i] + ( depth > 1 ? ":" + to_string( depth ) : "" );
+                result.measure( "filter" + suffix, [&]() { graph.removeAllEntitiesNotRelatedTo( centers[i], depth ); } );
+                result.measure( "arrows" + suffix, [&]() { graph.create_arrows(); } );
+                result.measure( "print" + suffix, [&]() { graph.print_graph( sink ); } );
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Writes xml to a file, reads it with an IncrementalReader and writes the
+ * diagram with an IncrementalWriter. Then every run renames a property in
+ * the middle, or renames it back, and writes again, timed as "patch". The
+ * file has to be patched, and the same as print_graph() of a graph read
+ * from scratch.
+ */
+bool check_patch( const string &xml, int runs, unsigned threads, Result &result ) {
+    auto at = xml.find( "<Property Name=\"", xml.size() / 2 );
+    if ( at == string::npos ) {
+        return true;
+    }
+    at += string_view{"<Property Name=\""}.size();
+    string edited = xml.substr( 0, at ) + "renamed_" + xml.substr( at );
+
+    auto directory = filesystem::temp_directory_path();
+    auto xmlFileName = ( directory / "esasbench_watch.xml" ).string();
+    auto dotFileName = ( directory / "esasbench_watch.dot" ).string();
+    auto save = [&]( const string &content ) { ofstream( xmlFileName, ios::binary ) << content; };
+
+    Graph graph;
+    IncrementalReader reader( graph, threads );
+    IncrementalWriter writer( dotFileName );
+    auto update = [&]() {
+        if ( !reader.read( xmlFileName.c_str() ) ) {
+            cout << reader.error() << endl;
+            return false;
+        }
+        graph.resolve();
+        graph.create_arrows();
+        return true;
+    };
+
+    bool same = true;
+    save( xml );
+    if ( !update() || !writer.write( graph ) ) {
+        same = false;
+    }
+    for ( int run = 0; run < runs && same; ++run ) {
+        const auto &content = run % 2 == 0 ? edited : xml;
+        save( content );
+        if ( !update() ) {
+            same = false;
+            break;
+        }
+        bool written = false;
+        result.measure( "patch", [&]() { written = writer.write( graph ); } );
+
+        auto doc = make_shared<XMLDocument>();
+        doc->SetNameClassifier( classify_edm_name );
+        doc->Parse( content.data(), content.size() );
+        Graph fresh;
+        fresh.borrow_from( doc );
+        fresh.visit( doc.get() );
+        fresh.resolve();
+        fresh.create_arrows();
+        ostringstream expected;
+        fresh.print_graph( expected );
+
+        if ( !written || !writer.patched() ) {
+            cout << result.input << ": the diagram was not patched " << writer.error() << endl;
+            same = false;
+        } else if ( read_file( dotFileName ) != expected.str() ) {
+            cout << result.input << ": the patched diagram differs from a fresh render" << endl;
+            same = false;
+        }
+    }
+
+    error_code error;
+    filesystem::remove( xmlFileName, error );
+    filesystem::remove( dotFileName, error );
+    return same;
+}
+
+void print_results( const vector<Result> &results, int runs ) {
+    for ( const auto &result : results ) {
+        cout << result.input << ": " << fixed << setprecision( 1 ) << static_cast<double>( result.bytes ) / ( 1024.0 * 1024.0 ) << " MB, "
+             << result.entities << " entities, " << result.edges << " edges, " << runs << " runs" << endl;
+        cout << "  " << left << setw( 16 ) << "phase" << right << setw( 12 ) << "median ms" << setw( 12 ) << "p95 ms" << setw( 12 ) << "allocs" << endl;
+        for ( const auto &phase : result.phases ) {
+            cout << "  " << left << setw( 16 ) << phase.name << right << setprecision( 3 ) << setw( 12 ) << percentile( phase.seconds, 0.5 ) * 1000
+                 << setw( 12 ) << percentile( phase.seconds, 0.95 ) * 1000 << setw( 12 ) << percentile( phase.allocations, 0.5 ) << endl;
+        }
+        cout << endl;
+    }
+}
+
+void write_json( const vector<Result> &results, int runs, const string &fileName ) {
+    ofstream json( fileName );
+    json << "{\n  \"runs\": " << runs << ",\n  \"inputs\": [";
+    for ( size_t r = 0; r < results.size(); ++r ) {
+        const auto &result = results[r];
+        json << ( r == 0 ? "\n" : ",\n" ) << "    {\n      \"input\": ";
+        print_json_string( json, result.input );
+        json << ",\n      \"bytes\": " << result.bytes
+             << ",\n      \"entities\": " << result.entities << ",\n      \"edges\": " << result.edges << ",\n      \"phases\": {";
+        for ( size_t p = 0; p < result.phases.size(); ++p ) {
+            const auto &phase = result.phases[p];
+            json << ( p == 0 ? "\n" : ",\n" ) << "        \"" << phase.name << "\": {\"median_s\": " << scientific << setprecision( 6 )
+                 << percentile( phase.seconds, 0.5 ) << ", \"p95_s\": " << percentile( phase.seconds, 0.95 ) << ", \"allocations\": "
+                 << percentile( phase.allocations, 0.5 ) << "}";
+        }
+        json << "\n      }\n    }";
+    }
+    json << "\n  ]\n}" << endl;
+}
+
+int run_kernels( const string &fileName, int scale, int runs ) {
+    auto xml = read_file( fileName );
+    if ( xml.empty() ) {
+        cout << "Couldn't open input file " << fileName << endl;
+        return 1;
+    }
+
+    auto document = scale_document( xml, scale );
+    double megabytes = static_cast<double>( document.size() ) / ( 1024.0 * 1024.0 );
+    cout << "Parsing " << fixed << setprecision( 1 ) << megabytes << " MB (" << scale << "x " << fileName << "), median of " << runs << " runs" << endl
+         << endl;
+
+    double scalarSpeed = 0;
+    for ( auto kernel : {XMLUtil::SCAN_SCALAR, XMLUtil::SCAN_SSE42, XMLUtil::SCAN_AVX2} ) {
+        if ( XMLUtil::SetScanKernel( kernel ) != kernel ) {
+            cout << setw( 8 ) << XMLUtil::ScanKernelName( kernel ) << "  not supported on this CPU" << endl;
+            continue;
+        }
+
+        double seconds = median_parse_seconds( document, runs );
+        double speed = seconds > 0 ? megabytes / seconds : 0;
+        if ( kernel == XMLUtil::SCAN_SCALAR ) {
+            scalarSpeed = speed;
+        }
+        cout << setw( 8 ) << XMLUtil::ScanKernelName( kernel ) << setw( 10 ) << setprecision( 1 ) << speed << " MB/s"
+             << setw( 8 ) << setprecision( 2 ) << ( scalarSpeed > 0 ? speed / scalarSpeed : 0 ) << "x" << endl;
+    }
+
+    XMLUtil::SetScanKernel( XMLUtil::SCAN_AUTO );
+    return 0;
+}
+
+auto main( int argc, char **argv ) -> int {
+
+    int runs = 5;
+    int scale = 100;
+    unsigned threads = max( 1u, thread::hardware_concurrency() );
+    bool kernels = false;
+    string jsonFileName;
+    vector<string> inputs;
+
+    for ( int i = 1; i < argc; ++i ) {
+        auto argument = string_view{argv[i]};
+        if ( argument == "--runs" && i + 1 < argc ) {
+            runs = max( 1, atoi( argv[++i] ) );
+        } else if ( argument == "--json" && i + 1 < argc ) {
+            jsonFileName = argv[++i];
+        } else if ( argument == "--kernels" ) {
+            kernels = true;
+        } else if ( argument == "--scale" && i + 1 < argc ) {
+            scale = max( 1, atoi( argv[++i] ) );
+        } else if ( argument == "--threads" && i + 1 < argc ) {
+            threads = static_cast<unsigned>( max( 1, atoi( argv[++i] ) ) );
+        } else {
+            inputs.emplace_back( argument );
+        }
+    }
+
+    if ( kernels ) {
+        if ( inputs.size() != 1 ) {
+            cout << "Usage: esasbench --kernels [--scale <n>] [--runs <n>] <metadata file>" << endl;
+            return 1;
+        }
+        return run_kernels( inputs[0], scale, runs );
+    }
+
+    if ( inputs.empty() ) {
+        inputs = {"gen:1000", "gen:10000", "gen:10000:powerlaw", "gen:100000:powerlaw"};
+    }
+
+    vector<Result> results;
+    for ( const auto &input : inputs ) {
+        auto xml = load_input( input );
+        if ( xml.empty() ) {
+            cout << "Couldn't read input " << input << endl;
+            return 1;
+        }
+        results.push_back( run_input( input, xml, runs, threads ) );
+        if ( !check_patch( xml, runs, threads, results.back() ) ) {
+            return 1;
+        }
+    }
+
+    print_results( results, runs );
+    if ( !jsonFileName.empty() ) {
+        write_json( results, runs, jsonFileName );
+    }
+    return 0;
+}
@@ -0,0 +1,243 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "Generator.h"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// splitmix64 --
+class Random {
+  public:
+    explicit Random( uint64_t seed ) : state( seed ) {}
+
+    uint64_t next() {
+        uint64_t z = ( state += 0x9E3779B97F4A7C15ull );
+        z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+        z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+        return z ^ ( z >> 31 );
+    }
+
+    // Uniform in [0, bound) --
+    size_t below( size_t bound ) {
+        return bound == 0 ? 0 : static_cast<size_t>( next() % bound );
+    }
+
+    // Uniform around mean, in [0, 2 * mean] --
+    size_t around( size_t mean ) {
+        return below( 2 * mean + 1 );
+    }
+
+  private:
+    uint64_t state;
+};
+
+/**
+ * Zipf distribution over entity ranks: rank k is drawn with weight
+ * 1 / ( k + 1 )^alpha. Sampling is a binary search in the cumulative table.
+ *
+ * The weights are computed in fixed point with integer arithmetic only, as
+ * pow() may round differently between C libraries: alpha to 16 fraction
+ * bits, log2( k + 1 ) and 2^-x to 31.
+ */
+class PowerLaw {
+  public:
+    PowerLaw( size_t count, double alpha ) : cumulative( count ) {
+        // 2^( -2^-i ) for the bits of a fraction, each the square root of the one before --
+        uint64_t halvings[Bits + 1];
+        halvings[0] = One / 2;
+        for ( int i = 1; i <= Bits; ++i ) {
+            halvings[i] = square_root( halvings[i - 1] << Bits );
+        }
+
+        auto exponent = static_cast<uint64_t>( llround( clamp( alpha, 0.0, 32.0 ) * 65536 ) );
+        uint64_t sum = 0;
+        for ( size_t k = 0; k < count; ++k ) {
+            uint64_t x = ( exponent * fixed_log2( k + 1 ) ) >> 16; // alpha * log2( k + 1 )
+            uint64_t weight = One;
+            for ( int i = 1; i <= Bits; ++i ) {
+                if ( x & ( One >> i ) ) {
+                    weight = ( weight * halvings[i] ) >> Bits;
+                }
+            }
+            sum += ( x >> Bits ) < 64 ? weight >> ( x >> Bits ) : 0;
+            cumulative[k] = sum;
+        }
+    }
+
+    size_t sample( Random &random ) const {
+        uint64_t value = random.next() % max<uint64_t>( cumulative.back(), 1 );
+        auto found = upper_bound( cumulative.begin(), cumulative.end(), value );
+        return min( static_cast<size_t>( found - cumulative.begin() ), cumulative.size() - 1 );
+    }
+
+  private:
+    static constexpr int Bits = 31;
+    static constexpr uint64_t One = uint64_t{1} << Bits;
+
+    static uint64_t square_root( uint64_t value ) {
+        uint64_t root = 0;
+        for ( uint64_t bit = uint64_t{1} << 62; bit != 0; bit >>= 2 ) {
+            if ( value >= root + bit ) {
+                value -= root + bit;
+                root = ( root >> 1 ) + bit;
+            } else {
+                root >>= 1;
+            }
+        }
+        return root;
+    }
+
+    // log2( n ) with Bits fraction bits, by repeated squaring of the mantissa --
+    static uint64_t fixed_log2( uint64_t n ) {
+        int whole = 63;
+        while ( ( n >> whole ) == 0 ) {
+            --whole;
+        }
+        uint64_t mantissa = whole > Bits ? n >> ( whole - Bits ) : n << ( Bits - whole ); // In [1, 2)
+        uint64_t result = static_cast<uint64_t>( whole ) << Bits;
+        for ( int i = 1; i <= Bits; ++i ) {
+            mantissa = ( mantissa * mantissa ) >> Bits;
+            if ( mantissa >= ( uint64_t{2} << Bits ) ) {
+                mantissa >>= 1;
+                result |= uint64_t{1} << ( Bits - i );
+            }
+        }
+        return result;
+    }
+
+    vector<uint64_t> cumulative;
+};
+
+constexpr string_view hubNames[] = {"SystemUser", "BusinessUnit", "Team", "Organization", "Currency", "TransactionCurrency", "Owner", "Calendar"};
+constexpr string_view propertyTypes[] = {"Edm.Guid", "Edm.String", "Edm.Int32", "Edm.DateTimeOffset", "Edm.Boolean", "Edm.Decimal", "Edm.Int64"};
+
+string entity_name( const GeneratorOptions &options, size_t rank ) {
+    if ( options.powerLaw && rank < options.hubs ) {
+        return rank < size( hubNames ) ? string{hubNames[rank]} : "Hub" + to_string( rank );
+    }
+    return "Entity" + to_string( rank );
+}
+
+size_t schema_of( const GeneratorOptions &options, size_t rank ) {
+    return rank % options.schemas;
+}
+
+string qualified_name( const GeneratorOptions &options, size_t rank ) {
+    size_t schema = schema_of( options, rank );
+    string qualifier = options.aliases ? "s" + to_string( schema ) : "gen.Schema" + to_string( schema );
+    return qualifier + "." + entity_name( options, rank );
+}
+
+void write_entity( FILE *out, const GeneratorOptions &options, size_t rank, Random &random, const optional<PowerLaw> &powerLaw ) {
+    auto name = entity_name( options, rank );
+    auto target = [&]() { return powerLaw ? powerLaw->sample( random ) : random.below( options.entities ); };
+
+    fprintf( out, "<EntityType Name=\"%s\">\n<Key><PropertyRef Name=\"%sId\"/></Key>\n", name.c_str(), name.c_str() );
+    fprintf( out, "<Property Name=\"%sId\" Type=\"Edm.Guid\" Nullable=\"false\"/>\n", name.c_str() );
+
+    size_t properties = max<size_t>( 1, random.around( options.properties ) );
+    for ( size_t i = 1; i < properties; ++i ) {
+        fprintf( out, "<Property Name=\"attribute_%zu\" Type=\"%s\"/>\n", i, propertyTypes[random.below( size( propertyTypes ) )].data() );
+    }
+
+    // Navigations with constraints, each backed by foreign key properties --
+
+    size_t navigations = random.around( options.navigations );
+    vector<size_t> targets( navigations );
+    for ( size_t i = 0; i < navigations; ++i ) {
+        targets[i] = target();
+        for ( size_t c = 0; c < options.constraints; ++c ) {
+            fprintf( out, "<Property Name=\"fk_%zu_%zu\" Type=\"Edm.Guid\"/>\n", i, c );
+        }
+    }
+    for ( size_t i = 0; i < navigations; ++i ) {
+        auto targetName = entity_name( options, targets[i] );
+        fprintf( out, "<NavigationProperty Name=\"nav_%zu_%s\" Type=\"%s\">\n", i, targetName.c_str(), qualified_name( options, targets[i] ).c_str() );
+        for ( size_t c = 0; c < options.constraints; ++c ) {
+            fprintf( out, "<ReferentialConstraint Property=\"fk_%zu_%zu\" ReferencedProperty=\"%sId\"/>\n", i, c, targetName.c_str() );
+        }
+        fprintf( out, "</NavigationProperty>\n" );
+    }
+
+    size_t collections = random.around( options.collections );
+    for ( size_t i = 0; i < collections; ++i ) {
+        size_t to = target();
+        fprintf( out, "<NavigationProperty Name=\"list_%zu_%s\" Type=\"Collection(%s)\"/>\n", i, entity_name( options, to ).c_str(),
+                 qualified_name( options, to ).c_str() );
+    }
+
+    fprintf( out, "</EntityType>\n" );
+}
+
+} // namespace
+
+bool generate_metadata( const GeneratorOptions &options, FILE *out ) {
+    Random random( options.seed );
+    optional<PowerLaw> powerLaw;
+    if ( options.powerLaw ) {
+        powerLaw.emplace( options.entities, options.alpha );
+    }
+
+    fprintf( out, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                  "<edmx:Edmx Version=\"4.0\" xmlns:edmx=\"http://docs.oasis-open.org/odata/ns/edmx\">\n"
+                  "<edmx:DataServices>\n" );
+
+    for ( size_t schema = 0; schema < options.schemas; ++schema ) {
+        fprintf( out, "<Schema Namespace=\"gen.Schema%zu\" Alias=\"s%zu\" xmlns=\"http://docs.oasis-open.org/odata/ns/edm\">\n", schema, schema );
+        for ( size_t rank = schema; rank < options.entities; rank += options.schemas ) {
+            write_entity( out, options, rank, random, powerLaw );
+        }
+
+        // All sets go into the container of the last schema --
+
+        if ( schema + 1 == options.schemas ) {
+            fprintf( out, "<EntityContainer Name=\"Container\">\n" );
+            for ( size_t rank = 0; rank < options.entities; ++rank ) {
+                auto name = entity_name( options, rank );
+                auto type = qualified_name( options, rank );
+                for ( size_t set = 0; set < options.setsPerType; ++set ) {
+                    if ( set == 0 ) {
+                        fprintf( out, "<EntitySet Name=\"%s\" EntityType=\"%s\"/>\n", name.c_str(), type.c_str() );
+                    } else {
+                        fprintf( out, "<EntitySet Name=\"%s_%zu\" EntityType=\"%s\"/>\n", name.c_str(), set, type.c_str() );
+                    }
+                }
+            }
+            fprintf( out, "</EntityContainer>\n" );
+        }
+        fprintf( out, "</Schema>\n" );
+    }
+
+    fprintf( out, "</edmx:DataServices>\n</edmx:Edmx>\n" );
+
+    return ferror( out ) == 0;
+}
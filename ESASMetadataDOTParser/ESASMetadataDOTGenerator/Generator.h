@@ -0,0 +1,65 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef Generator_h
+#define Generator_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * Synthetic CSDL metadata generator for scaling benchmarks.
+ *
+ * Writes an edmx document with the requested number of schemas, entity
+ * types, properties, navigation properties, referential constraints and
+ * entity sets. Navigation targets are drawn uniformly or from a power law,
+ * where a few hub entities (SystemUser, BusinessUnit, ...) are the target of
+ * most references, as CreatedBy/OwningBusinessUnit are in CRM metadata.
+ *
+ * The random generator and distributions are implemented here rather than
+ * taken from <random>, whose distributions differ between standard
+ * libraries, so a seed gives the same document everywhere.
+ */
+struct GeneratorOptions {
+    uint64_t seed = 1;
+    size_t schemas = 1;
+    size_t entities = 1000;
+    size_t properties = 20;  // Mean per entity
+    size_t navigations = 4;  // Mean per entity, each with referential constraints
+    size_t constraints = 1;  // Per navigation property
+    size_t collections = 1;  // Mean per entity, Collection() navigations without constraints
+    size_t setsPerType = 1;  // EntitySets per entity type
+    size_t hubs = 4;         // Entities that attract most references with --distribution powerlaw
+    double alpha = 1.1;      // Power law exponent
+    bool powerLaw = false;
+    bool aliases = false;    // Refer to types through the Schema Alias
+};
+
+/**
+ * Writes the document to out. Returns false on a write error.
+ */
+bool generate_metadata( const GeneratorOptions &options, FILE *out );
+
+#endif /* Generator_h */
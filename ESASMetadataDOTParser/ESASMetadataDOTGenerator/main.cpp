@@ -0,0 +1,87 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "Generator.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+auto main( int argc, char **argv ) -> int {
+
+    GeneratorOptions options;
+    vector<string_view> arguments;
+
+    for ( int i = 1; i < argc; ++i ) {
+        auto argument = string_view{argv[i]};
+        auto value = [&]() { return i + 1 < argc ? strtoull( argv[++i], nullptr, 10 ) : 0ull; };
+
+        if ( argument == "--seed" ) {
+            options.seed = value();
+        } else if ( argument == "--schemas" ) {
+            options.schemas = max<size_t>( 1, value() );
+        } else if ( argument == "--entities" ) {
+            options.entities = max<size_t>( 1, value() );
+        } else if ( argument == "--properties" ) {
+            options.properties = value();
+        } else if ( argument == "--navigations" ) {
+            options.navigations = value();
+        } else if ( argument == "--constraints" ) {
+            options.constraints = max<size_t>( 1, value() );
+        } else if ( argument == "--collections" ) {
+            options.collections = value();
+        } else if ( argument == "--sets" ) {
+            options.setsPerType = value();
+        } else if ( argument == "--hubs" ) {
+            options.hubs = value();
+        } else if ( argument == "--alpha" && i + 1 < argc ) {
+            options.alpha = atof( argv[++i] );
+        } else if ( argument == "--distribution" && i + 1 < argc ) {
+            options.powerLaw = string_view{argv[++i]} == "powerlaw";
+        } else if ( argument == "--aliases" ) {
+            options.aliases = true;
+        } else {
+            arguments.push_back( argument );
+        }
+    }
+
+    if ( arguments.size() != 1 ) {
+        cout << "Usage: esasgen [--seed <n>] [--schemas <n>] [--entities <n>] [--properties <mean>] [--navigations <mean>]" << endl
+             << "               [--constraints <n>] [--collections <mean>] [--sets <per type>] [--aliases]" << endl
+             << "               [--distribution uniform | powerlaw] [--hubs <n>] [--alpha <exponent>] <output file>" << endl;
+        return 1;
+    }
+
+    FILE *out = fopen( arguments[0].data(), "wb" );
+    bool written = out != nullptr && generate_metadata( options, out );
+    if ( out == nullptr || fclose( out ) != 0 || !written ) {
+        cout << "Couldn't write output file " << arguments[0] << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "Adjacency.h"
+
+using namespace std;
+
+void Adjacency::build( const EDMModel &model ) {
+    nodeOfName.assign( model.strings.size(), None );
+    nodeNames.clear();
+
+    auto node_of = [&]( EDMModel::Id name ) {
+        if ( nodeOfName[name] == None ) {
+            nodeOfName[name] = node_count();
+            nodeNames.push_back( name );
+        }
+        return nodeOfName[name];
+    };
+
+    vector<Node> entityNodes( model.entity_count() );
+    for ( uint32_t entity = 0; entity < model.entity_count(); ++entity ) {
+        entityNodes[entity] = node_of( model.entityNames[entity] );
+    }
+
+    edgeSources.resize( model.edge_count() );
+    edgeTargets.resize( model.edge_count() );
+    for ( uint32_t edge = 0; edge < model.edge_count(); ++edge ) {
+        edgeSources[edge] = node_of( model.edge_source_name( edge ) );
+        edgeTargets[edge] = node_of( model.edgeTargets[edge] );
+    }
+
+    fill( outOffsets, outEdges, edgeSources, node_count() );
+    fill( inOffsets, inEdges, edgeTargets, node_count() );
+    fill( entityOffsets, entityList, entityNodes, node_count() );
+}
+
+/**
+ * Counting sort of the indices 0..keys.size() by key. Indices with the same
+ * key stay in ascending order.
+ */
+void Adjacency::fill( vector<uint32_t> &offsets, vector<uint32_t> &items, const vector<Node> &keys, uint32_t nodes ) {
+    offsets.assign( nodes + 1, 0 );
+    for ( Node key : keys ) {
+        ++offsets[key + 1];
+    }
+    for ( uint32_t i = 0; i < nodes; ++i ) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    items.resize( keys.size() );
+    vector<uint32_t> next( offsets.begin(), offsets.end() - 1 );
+    for ( uint32_t i = 0; i < keys.size(); ++i ) {
+        items[next[keys[i]]++] = i;
+    }
+}
+
+bool Adjacency::Bits::none() const {
+    return all_of( words.begin(), words.end(), []( uint64_t word ) { return word == 0; } );
+}
+
+unsigned Adjacency::Bits::count_trailing_zeros( uint64_t word ) {
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return static_cast<unsigned>( __builtin_ctzll( word ) );
+#else
+    unsigned bits = 0;
+    for ( ; ( word & 1 ) == 0; word >>= 1 ) {
+        ++bits;
+    }
+    return bits;
+#endif
+}
+
+void Adjacency::neighborhood( Bits &visited, Bits &edges, unsigned depth, Direction direction ) const {
+    Bits frontier = visited;
+    Bits next( node_count() );
+
+    auto follow = [&]( uint32_t edge, Node node ) {
+        edges.set( edge );
+        if ( !visited.test( node ) ) {
+            visited.set( node );
+            next.set( node );
+        }
+    };
+
+    for ( unsigned level = 0; level < depth && !frontier.none(); ++level ) {
+        frontier.for_each( [&]( Node node ) {
+            if ( direction != Direction::In ) {
+                for ( uint32_t edge : out( node ) ) {
+                    follow( edge, target( edge ) );
+                }
+            }
+            if ( direction != Direction::Out ) {
+                for ( uint32_t edge : in( node ) ) {
+                    follow( edge, source( edge ) );
+                }
+            }
+        } );
+        frontier.swap( next );
+        next.clear();
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef Adjacency_h
+#define Adjacency_h
+
+#include "EDMModel.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compressed sparse row index over the navigation edges of an EDMModel.
+ *
+ * Every entity name and every edge endpoint becomes a node; entities that
+ * share a name share a node. For each node the outgoing edges, the incoming
+ * edges and the entities with that name are contiguous slices of edge and
+ * entity indices, in document order.
+ */
+class Adjacency {
+  public:
+    typedef uint32_t Node;
+    static constexpr Node None = UINT32_MAX;
+
+    enum class Direction { Out, In, Both };
+
+    /**
+     * Dense bitset over nodes or edges, one bit each.
+     */
+    class Bits {
+      public:
+        explicit Bits( size_t size = 0 ) : words( ( size + 63 ) / 64 ) {}
+
+        void set( uint32_t i ) { words[i / 64] |= uint64_t{1} << ( i % 64 ); }
+        void reset( uint32_t i ) { words[i / 64] &= ~( uint64_t{1} << ( i % 64 ) ); }
+        bool test( uint32_t i ) const { return ( words[i / 64] >> ( i % 64 ) & 1 ) != 0; }
+        bool none() const;
+        void clear() { std::fill( words.begin(), words.end(), 0 ); }
+        void swap( Bits &other ) { words.swap( other.words ); }
+
+        // Calls f( i ) for every set bit in ascending order --
+        template <typename F>
+        void for_each( F f ) const {
+            for ( size_t w = 0; w < words.size(); ++w ) {
+                for ( uint64_t word = words[w]; word != 0; word &= word - 1 ) {
+                    f( static_cast<uint32_t>( w * 64 + count_trailing_zeros( word ) ) );
+                }
+            }
+        }
+
+      private:
+        static unsigned count_trailing_zeros( uint64_t word );
+
+        std::vector<uint64_t> words;
+    };
+
+    struct Slice {
+        const uint32_t *first;
+        const uint32_t *last;
+        const uint32_t *begin() const { return first; }
+        const uint32_t *end() const { return last; }
+        size_t size() const { return static_cast<size_t>( last - first ); }
+    };
+
+    void build( const EDMModel &model );
+
+    Node node( EDMModel::Id name ) const { return name < nodeOfName.size() ? nodeOfName[name] : None; }
+    uint32_t node_count() const { return static_cast<uint32_t>( nodeNames.size() ); }
+    uint32_t edge_count() const { return static_cast<uint32_t>( edgeSources.size() ); }
+    EDMModel::Id name( Node node ) const { return nodeNames[node]; }
+
+    Node source( uint32_t edge ) const { return edgeSources[edge]; }
+    Node target( uint32_t edge ) const { return edgeTargets[edge]; }
+
+    Slice out( Node node ) const { return slice( outOffsets, outEdges, node ); }
+    Slice in( Node node ) const { return slice( inOffsets, inEdges, node ); }
+    Slice entities( Node node ) const { return slice( entityOffsets, entityList, node ); }
+
+    /**
+     * Breadth first search from the nodes set in visited, up to depth edges
+     * away, along edges in direction. Sets the nodes reached in visited and
+     * every edge followed out of a node closer than depth in edges. Each
+     * level is a bitset frontier, so a level costs the edges of its nodes
+     * plus a scan over node_count() / 64 words.
+     */
+    void neighborhood( Bits &visited, Bits &edges, unsigned depth, Direction direction ) const;
+
+  private:
+    static Slice slice( const std::vector<uint32_t> &offsets, const std::vector<uint32_t> &items, Node node ) {
+        return {items.data() + offsets[node], items.data() + offsets[node + 1]};
+    }
+
+    static void fill( std::vector<uint32_t> &offsets, std::vector<uint32_t> &items, const std::vector<Node> &keys, uint32_t nodes );
+
+    std::vector<Node> nodeOfName; // String id -> node
+    std::vector<EDMModel::Id> nodeNames;
+    std::vector<Node> edgeSources;
+    std::vector<Node> edgeTargets;
+
+    std::vector<uint32_t> outOffsets, outEdges;
+    std::vector<uint32_t> inOffsets, inEdges;
+    std::vector<uint32_t> entityOffsets, entityList;
+};
+
+#endif /* Adjacency_h */
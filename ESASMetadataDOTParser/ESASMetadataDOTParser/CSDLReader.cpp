@@ -0,0 +1,404 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#include "CSDLReader.h"
+#include "EDM.h"
+#include "Graph.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+bool is_space( char c ) {
+    return isspace( static_cast<unsigned char>( c ) ) != 0;
+}
+
+char *encode_utf8( unsigned long codePoint, char *out ) {
+    if ( codePoint < 0x80 ) {
+        *out++ = static_cast<char>( codePoint );
+    } else if ( codePoint < 0x800 ) {
+        *out++ = static_cast<char>( 0xC0 | ( codePoint >> 6 ) );
+        *out++ = static_cast<char>( 0x80 | ( codePoint & 0x3F ) );
+    } else if ( codePoint < 0x10000 ) {
+        *out++ = static_cast<char>( 0xE0 | ( codePoint >> 12 ) );
+        *out++ = static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) );
+        *out++ = static_cast<char>( 0x80 | ( codePoint & 0x3F ) );
+    } else {
+        *out++ = static_cast<char>( 0xF0 | ( codePoint >> 18 ) );
+        *out++ = static_cast<char>( 0x80 | ( ( codePoint >> 12 ) & 0x3F ) );
+        *out++ = static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) );
+        *out++ = static_cast<char>( 0x80 | ( codePoint & 0x3F ) );
+    }
+    return out;
+}
+
+} // namespace
+
+CSDLReader::CSDLReader( Graph &graph, size_t chunkSize ) : graph( graph ), buffer( chunkSize ), chunk( chunkSize ) {
+}
+
+bool CSDLReader::read( const char *fileName ) {
+    FILE *fp = fopen( fileName, "rb" );
+    if ( fp == nullptr ) {
+        errorText = "Couldn't open input file " + string{fileName};
+        return false;
+    }
+    bool result = read( fp );
+    fclose( fp );
+    return result;
+}
+
+bool CSDLReader::read( FILE *fp ) {
+    input = fp;
+    position = filled = totalRead = 0;
+    eof = false;
+    errorText.clear();
+    scopes.clear();
+
+    for ( ;; ) {
+
+        // Skip character data up to the next markup --
+
+        auto lt = static_cast<char *>( memchr( buffer.data() + position, '<', filled - position ) );
+        if ( lt == nullptr ) {
+            position = filled;
+            if ( !fill() ) {
+                break;
+            }
+            continue;
+        }
+        position = static_cast<size_t>( lt - buffer.data() );
+
+        size_t markupEnd = 0;
+        if ( !find_markup_end( markupEnd ) ) {
+            errorText = "Unterminated markup at end of file";
+            return false;
+        }
+        if ( !parse_tag( buffer.data() + position, buffer.data() + markupEnd ) ) {
+            return false;
+        }
+        position = markupEnd + 1;
+    }
+
+    if ( ferror( fp ) ) {
+        errorText = "Error reading input file";
+        return false;
+    }
+    if ( !scopes.empty() ) {
+        errorText = "Unexpected end of file inside an element";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Moves the unconsumed data at position to the front of the buffer and reads
+ * the next chunk behind it. The buffer only grows when a single tag is larger
+ * than what is already buffered.
+ */
+bool CSDLReader::fill() {
+    if ( eof ) {
+        return false;
+    }
+
+    if ( position > 0 ) {
+        memmove( buffer.data(), buffer.data() + position, filled - position );
+        filled -= position;
+        position = 0;
+    }
+    if ( buffer.size() - filled < chunk ) {
+        buffer.resize( filled + chunk );
+    }
+
+    size_t count = fread( buffer.data() + filled, 1, chunk, input );
+    filled += count;
+    totalRead += count;
+    if ( count < chunk ) {
+        eof = true;
+    }
+    return count > 0;
+}
+
+/**
+ * Finds the closing '>' of the markup starting at position, reading more
+ * input when the markup straddles the end of the buffer. Offsets are kept
+ * relative to position since fill() moves the data.
+ */
+bool CSDLReader::find_markup_end( size_t &markupEnd ) {
+
+    auto starts_with = [&]( string_view prefix ) {
+        while ( filled - position < prefix.size() ) {
+            if ( !fill() ) {
+                return false;
+            }
+        }
+        return string_view{buffer.data() + position, prefix.size()} == prefix;
+    };
+
+    // Comments, CDATA sections and processing instructions end with a fixed terminator --
+
+    string_view terminator;
+    if ( starts_with( "<!--" ) ) {
+        terminator = "-->";
+    } else if ( starts_with( "<![CDATA[" ) ) {
+        terminator = "]]>";
+    } else if ( starts_with( "<?" ) ) {
+        terminator = "?>";
+    }
+
+    if ( !terminator.empty() ) {
+        size_t offset = 1;
+        for ( ;; ) {
+            auto data = string_view{buffer.data() + position, filled - position};
+            auto found = data.find( terminator, offset );
+            if ( found != string_view::npos ) {
+                markupEnd = position + found + terminator.size() - 1;
+                return true;
+            }
+            if ( data.size() > terminator.size() ) {
+                offset = data.size() - terminator.size() + 1;
+            }
+            if ( !fill() ) {
+                return false;
+            }
+        }
+    }
+
+    // Tags and declarations end at the first '>' outside quotes and internal subsets --
+
+    char quote = 0;
+    int brackets = 0;
+    size_t offset = 1;
+    for ( ;; ) {
+        for ( ; position + offset < filled; ++offset ) {
+            char c = buffer[position + offset];
+            if ( quote != 0 ) {
+                if ( c == quote ) {
+                    quote = 0;
+                }
+            } else if ( c == '"' || c == '\'' ) {
+                quote = c;
+            } else if ( c == '[' ) {
+                ++brackets;
+            } else if ( c == ']' ) {
+                --brackets;
+            } else if ( c == '>' && brackets <= 0 ) {
+                markupEnd = position + offset;
+                return true;
+            }
+        }
+        if ( !fill() ) {
+            return false;
+        }
+    }
+}
+
+bool CSDLReader::parse_tag( char *begin, char *end ) {
+    char *p = begin + 1;
+
+    // Comments, CDATA, declarations and processing instructions carry no model data --
+
+    if ( *p == '!' || *p == '?' ) {
+        return true;
+    }
+
+    if ( *p == '/' ) {
+        if ( scopes.empty() ) {
+            errorText = "Unexpected end tag " + string{p + 1, end};
+            return false;
+        }
+        end_element();
+        return true;
+    }
+
+    bool selfClosing = end[-1] == '/';
+    char *tagEnd = selfClosing ? end - 1 : end;
+
+    char *nameEnd = p;
+    while ( nameEnd < tagEnd && !is_space( *nameEnd ) ) {
+        ++nameEnd;
+    }
+    auto name = string_view{p, static_cast<size_t>( nameEnd - p )};
+    if ( name.empty() ) {
+        errorText = "Malformed tag";
+        return false;
+    }
+
+    attributes.fill( {} );
+    for ( p = nameEnd;; ) {
+        while ( p < tagEnd && is_space( *p ) ) {
+            ++p;
+        }
+        if ( p == tagEnd ) {
+            break;
+        }
+
+        char *key = p;
+        while ( p < tagEnd && *p != '=' && !is_space( *p ) ) {
+            ++p;
+        }
+        auto keyName = string_view{key, static_cast<size_t>( p - key )};
+        while ( p < tagEnd && is_space( *p ) ) {
+            ++p;
+        }
+        if ( p == tagEnd || *p != '=' ) {
+            errorText = "Malformed attribute " + string{keyName} + " in " + string{name};
+            return false;
+        }
+        ++p;
+        while ( p < tagEnd && is_space( *p ) ) {
+            ++p;
+        }
+        if ( p == tagEnd || ( *p != '"' && *p != '\'' ) ) {
+            errorText = "Unquoted attribute " + string{keyName} + " in " + string{name};
+            return false;
+        }
+
+        char quote = *p++;
+        char *value = p;
+        while ( p < tagEnd && *p != quote ) {
+            ++p;
+        }
+        if ( p == tagEnd ) {
+            errorText = "Unterminated attribute " + string{keyName} + " in " + string{name};
+            return false;
+        }
+        char *valueEnd = decode_entities( value, p );
+        attributes[classify_edm_name( keyName.data(), keyName.size() )] = string_view{value, static_cast<size_t>( valueEnd - value )};
+        ++p;
+    }
+
+    start_element( edm_name( classify_edm_name( name.data(), name.size() ) ) );
+    if ( selfClosing ) {
+        end_element();
+    }
+    return true;
+}
+
+void CSDLReader::start_element( EDMName name ) {
+    Scope parent = scopes.empty() ? Scope::Other : scopes.back();
+    Scope scope = Scope::Other;
+
+    switch ( name ) {
+    case EDMName::Schema:
+        graph.begin_schema( attribute( EDMName::Namespace ), attribute( EDMName::Alias ) );
+        break;
+
+    case EDMName::EntityType:
+        graph.begin_entity_type( attribute( EDMName::Name ) );
+        scope = Scope::EntityType;
+        break;
+
+    case EDMName::Property:
+        if ( parent == Scope::EntityType ) {
+            graph.add_property( attribute( EDMName::Name ), attribute( EDMName::Type ) );
+        }
+        break;
+
+    case EDMName::NavigationProperty:
+        if ( parent == Scope::EntityType ) {
+            navigationType = attribute( EDMName::Type );
+            scope = Scope::NavigationProperty;
+        }
+        break;
+
+    case EDMName::ReferentialConstraint:
+        if ( parent == Scope::NavigationProperty ) {
+            graph.add_referential_constraint( navigationType, attribute( EDMName::Property ), attribute( EDMName::ReferencedProperty ) );
+        }
+        break;
+
+    case EDMName::EntitySet:
+        graph.add_entity( attribute( EDMName::Name ), attribute( EDMName::EntityType ) );
+        break;
+
+    default:
+        break;
+    }
+
+    scopes.push_back( scope );
+}
+
+void CSDLReader::end_element() {
+    Scope scope = scopes.back();
+    scopes.pop_back();
+    if ( scope == Scope::EntityType ) {
+        graph.end_entity_type();
+    }
+}
+
+/**
+ * Expands the predefined and numeric character references and normalizes
+ * line breaks in place, the same way tinyxml2 treats attribute values.
+ * Returns the new end of the value.
+ */
+char *CSDLReader::decode_entities( char *begin, char *end ) {
+    char *out = begin;
+    for ( char *in = begin; in < end; ) {
+        if ( *in == '\r' ) {
+            *out++ = '\n';
+            in += ( in + 1 < end && in[1] == '\n' ) ? 2 : 1;
+            continue;
+        }
+        if ( *in != '&' ) {
+            *out++ = *in++;
+            continue;
+        }
+
+        auto semicolon = static_cast<char *>( memchr( in, ';', static_cast<size_t>( end - in ) ) );
+        if ( semicolon == nullptr ) {
+            *out++ = *in++;
+            continue;
+        }
+
+        auto entity = string_view{in + 1, static_cast<size_t>( semicolon - in - 1 )};
+        if ( entity == "lt" ) {
+            *out++ = '<';
+        } else if ( entity == "gt" ) {
+            *out++ = '>';
+        } else if ( entity == "amp" ) {
+            *out++ = '&';
+        } else if ( entity == "quot" ) {
+            *out++ = '"';
+        } else if ( entity == "apos" ) {
+            *out++ = '\'';
+        } else if ( entity.size() > 1 && entity[0] == '#' ) {
+            bool hex = entity[1] == 'x';
+            char *digitsEnd = nullptr;
+            unsigned long codePoint = strtoul( in + ( hex ? 3 : 2 ), &digitsEnd, hex ? 16 : 10 );
+            if ( digitsEnd != semicolon || codePoint > 0x10FFFF ) {
+                *out++ = *in++;
+                continue;
+            }
+            out = encode_utf8( codePoint, out );
+        } else {
+            *out++ = *in++;
+            continue;
+        }
+        in = semicolon + 1;
+    }
+    return out;
+}
@@ -0,0 +1,84 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef CSDLReader_h
+#define CSDLReader_h
+
+#include "EDM.h"
+#include <array>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Graph;
+
+/**
+ * Streaming, event driven reader for CSDL metadata.
+ *
+ * The file is read in fixed size chunks and scanned tag by tag; no DOM is
+ * built. EntityType, Property, NavigationProperty, ReferentialConstraint and
+ * EntitySet elements are reported to the Graph as soon as they are seen, so
+ * memory use is bounded by the chunk size and the largest single tag.
+ */
+class CSDLReader {
+  public:
+    explicit CSDLReader( Graph &graph, size_t chunkSize = 64 * 1024 );
+
+    bool read( const char *fileName );
+    bool read( FILE *fp );
+
+    const std::string &error() const { return errorText; }
+    size_t bytesRead() const { return totalRead; }
+
+  private:
+    // Attribute values of the current tag, indexed by EDMName; unknown names share slot 0 --
+    typedef std::array<std::string_view, static_cast<size_t>( EDMName::Count )> Attributes;
+
+    enum class Scope { Other, EntityType, NavigationProperty };
+
+    bool fill();
+    bool find_markup_end( size_t &markupEnd );
+    bool parse_tag( char *begin, char *end );
+    void start_element( EDMName name );
+    void end_element();
+    std::string_view attribute( EDMName name ) const { return attributes[static_cast<size_t>( name )]; }
+
+    static char *decode_entities( char *begin, char *end );
+
+    Graph &graph;
+    FILE *input = nullptr;
+    std::vector<char> buffer;
+    size_t chunk;
+    size_t position = 0; // Start of the markup being scanned
+    size_t filled = 0;   // End of valid data in buffer
+    size_t totalRead = 0;
+    bool eof = false;
+    std::string errorText;
+
+    Attributes attributes;
+    std::vector<Scope> scopes;
+    std::string navigationType;
+};
+
+#endif /* CSDLReader_h */
@@ -0,0 +1,209 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "Communities.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+using namespace std;
+
+namespace {
+
+constexpr uint32_t ChunkSize = 1024; // Nodes per task in a round
+
+} // namespace
+
+void Communities::compute( const Adjacency &graph, const Adjacency::Bits &edges, uint32_t maxSize, unsigned threads ) {
+    uint32_t nodes = graph.node_count();
+    vector<uint32_t> labels( nodes );
+    iota( labels.begin(), labels.end(), 0 );
+    vector<uint32_t> sizes( nodes, 1 );
+    vector<uint32_t> proposed( nodes );
+
+    ThreadPool pool( threads );
+    size_t chunks = ( nodes + ChunkSize - 1 ) / ChunkSize;
+    for ( roundCount = 0; roundCount < MaxRounds; ) {
+        ++roundCount;
+
+        // Every node picks from the labels and sizes of the last round only, so no thread sees another's moves --
+
+        pool.parallel_for( chunks, [&]( size_t chunk ) {
+            vector<uint32_t> around; // Labels of the neighbours and its own, sorted to count them
+            for ( uint32_t node = static_cast<uint32_t>( chunk * ChunkSize ), end = min( nodes, node + ChunkSize ); node < end; ++node ) {
+                proposed[node] = labels[node];
+                around.clear();
+                for ( uint32_t edge : graph.out( node ) ) {
+                    if ( edges.test( edge ) && graph.target( edge ) != node ) {
+                        around.push_back( labels[graph.target( edge )] );
+                    }
+                }
+                for ( uint32_t edge : graph.in( node ) ) {
+                    if ( edges.test( edge ) && graph.source( edge ) != node ) {
+                        around.push_back( labels[graph.source( edge )] );
+                    }
+                }
+                if ( around.empty() ) {
+                    continue;
+                }
+
+                // Its own vote keeps two neighbours from swapping labels every round --
+
+                around.push_back( labels[node] );
+                sort( around.begin(), around.end() );
+
+                // The most frequent label with room left; labels ascend, so ties take the smallest --
+
+                size_t bestCount = 0;
+                for ( size_t i = 0, j; i < around.size(); i = j ) {
+                    for ( j = i + 1; j < around.size() && around[j] == around[i]; ++j ) {
+                    }
+                    uint32_t label = around[i];
+                    if ( label != labels[node] && sizes[label] >= maxSize ) {
+                        continue;
+                    }
+                    if ( j - i > bestCount ) {
+                        proposed[node] = label;
+                        bestCount = j - i;
+                    }
+                }
+            }
+        } );
+
+        // Moves are admitted in node order, taking their room in the community as they go, so no community
+        // grows past maxSize and the result is the same with any number of threads --
+
+        size_t changes = 0;
+        for ( uint32_t node = 0; node < nodes; ++node ) {
+            uint32_t label = proposed[node];
+            if ( label != labels[node] && sizes[label] < maxSize ) {
+                --sizes[labels[node]];
+                ++sizes[label];
+                labels[node] = label;
+                ++changes;
+            }
+        }
+        if ( changes == 0 ) {
+            break;
+        }
+    }
+
+    merge_small( graph, edges, maxSize, labels, sizes );
+
+    // Number the communities by their first node --
+
+    vector<uint32_t> number( nodes, UINT32_MAX );
+    communityOfNode.resize( nodes );
+    communityCount = 0;
+    for ( uint32_t node = 0; node < nodes; ++node ) {
+        uint32_t label = labels[node];
+        if ( number[label] == UINT32_MAX ) {
+            number[label] = communityCount++;
+        }
+        communityOfNode[node] = number[label];
+    }
+}
+
+/**
+ * Label propagation leaves many communities of one or two nodes at the edge
+ * of the model. Each community below a quarter of maxSize, smallest first,
+ * joins the neighbouring community it has the most arrows to if the two fit
+ * in maxSize together; ties go to the smaller neighbour, then the smaller
+ * label. Passes repeat until nothing merges.
+ */
+void Communities::merge_small( const Adjacency &graph, const Adjacency::Bits &edges, uint32_t maxSize, vector<uint32_t> &labels,
+                               vector<uint32_t> &sizes ) {
+    uint32_t nodes = graph.node_count();
+    uint32_t small = maxSize / 4;
+
+    vector<vector<uint32_t>> members( nodes );
+    for ( uint32_t node = 0; node < nodes; ++node ) {
+        members[labels[node]].push_back( node );
+    }
+
+    vector<uint32_t> links( nodes, 0 ); // Arrows from the community at hand, by label
+    vector<uint32_t> touched;
+    vector<pair<uint32_t, uint32_t>> order; // (size, label)
+    for ( bool merged = true; merged; ) {
+        merged = false;
+        order.clear();
+        for ( uint32_t label = 0; label < nodes; ++label ) {
+            if ( !members[label].empty() && sizes[label] < small ) {
+                order.emplace_back( sizes[label], label );
+            }
+        }
+        sort( order.begin(), order.end() );
+
+        for ( auto entry : order ) {
+            uint32_t label = entry.second;
+            if ( members[label].empty() || sizes[label] >= small ) {
+                continue; // Merged into another one, or grown, in this pass
+            }
+
+            touched.clear();
+            auto link = [&]( Adjacency::Node other ) {
+                uint32_t to = labels[other];
+                if ( to != label && links[to]++ == 0 ) {
+                    touched.push_back( to );
+                }
+            };
+            for ( auto node : members[label] ) {
+                for ( uint32_t edge : graph.out( node ) ) {
+                    if ( edges.test( edge ) ) {
+                        link( graph.target( edge ) );
+                    }
+                }
+                for ( uint32_t edge : graph.in( node ) ) {
+                    if ( edges.test( edge ) ) {
+                        link( graph.source( edge ) );
+                    }
+                }
+            }
+
+            uint32_t best = UINT32_MAX;
+            for ( auto to : touched ) {
+                if ( sizes[to] + sizes[label] <= maxSize &&
+                     ( best == UINT32_MAX || make_tuple( links[best], sizes[to], to ) < make_tuple( links[to], sizes[best], best ) ) ) {
+                    best = to;
+                }
+            }
+            for ( auto to : touched ) {
+                links[to] = 0;
+            }
+            if ( best == UINT32_MAX ) {
+                continue;
+            }
+
+            for ( auto node : members[label] ) {
+                labels[node] = best;
+            }
+            members[best].insert( members[best].end(), members[label].begin(), members[label].end() );
+            members[label] = vector<uint32_t>();
+            sizes[best] += sizes[label];
+            sizes[label] = 0;
+            merged = true;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef Communities_h
+#define Communities_h
+
+#include "Adjacency.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Communities of the nodes of an Adjacency by label propagation, for
+ * --partition.
+ *
+ * Every node starts in a community of its own and repeatedly joins the
+ * community most of its neighbours are in, ignoring edge direction, until a
+ * round changes nothing or the round limit is reached. A community stops
+ * taking members at maxSize nodes, which keeps hubs from pulling the whole
+ * model into one. The labels of a round are picked on a ThreadPool from
+ * those of the round before and then applied in node order, so the result
+ * does not depend on the number of threads. Small communities left over are
+ * then merged into their best linked neighbour, see merge_small().
+ */
+class Communities {
+  public:
+    static constexpr unsigned MaxRounds = 32;
+
+    void compute( const Adjacency &graph, const Adjacency::Bits &edges, uint32_t maxSize, unsigned threads = 1 );
+
+    uint32_t of( Adjacency::Node node ) const { return communityOfNode[node]; } // Numbered in order of their first node
+    uint32_t count() const { return communityCount; }
+    unsigned rounds() const { return roundCount; }
+
+  private:
+    static void merge_small( const Adjacency &graph, const Adjacency::Bits &edges, uint32_t maxSize, std::vector<uint32_t> &labels,
+                             std::vector<uint32_t> &sizes );
+
+    std::vector<uint32_t> communityOfNode;
+    uint32_t communityCount = 0;
+    unsigned roundCount = 0;
+};
+
+#endif /* Communities_h */
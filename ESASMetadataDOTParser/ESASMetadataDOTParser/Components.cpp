@@ -0,0 +1,150 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "Components.h"
+
+using namespace std;
+
+void Components::compute( const Adjacency &graph, const Adjacency::Bits &edges, Kind kind ) {
+    if ( kind == Kind::Strong ) {
+        strong( graph, edges );
+    } else {
+        weak( graph, edges );
+    }
+}
+
+/**
+ * Tarjan's algorithm. Each frame of the explicit stack is a node and the
+ * position in its outgoing edges, which is what the recursion would keep.
+ */
+void Components::strong( const Adjacency &graph, const Adjacency::Bits &edges ) {
+    constexpr uint32_t Unvisited = UINT32_MAX;
+    uint32_t nodes = graph.node_count();
+
+    vector<uint32_t> index( nodes, Unvisited );
+    vector<uint32_t> lowLink( nodes, 0 );
+    vector<bool> onStack( nodes, false );
+    vector<Adjacency::Node> stack;
+    vector<pair<Adjacency::Node, uint32_t>> frames;
+    componentOfNode.assign( nodes, 0 );
+    uint32_t nextIndex = 0;
+    uint32_t components = 0;
+
+    for ( Adjacency::Node root = 0; root < nodes; ++root ) {
+        if ( index[root] != Unvisited ) {
+            continue;
+        }
+        frames.emplace_back( root, 0 );
+        index[root] = lowLink[root] = nextIndex++;
+        stack.push_back( root );
+        onStack[root] = true;
+
+        while ( !frames.empty() ) {
+            auto &[node, position] = frames.back();
+            auto out = graph.out( node );
+            if ( position < out.size() ) {
+                uint32_t edge = out.begin()[position++];
+                if ( !edges.test( edge ) ) {
+                    continue;
+                }
+                auto next = graph.target( edge );
+                if ( index[next] == Unvisited ) {
+                    index[next] = lowLink[next] = nextIndex++;
+                    stack.push_back( next );
+                    onStack[next] = true;
+                    frames.emplace_back( next, 0 );
+                } else if ( onStack[next] ) {
+                    lowLink[node] = min( lowLink[node], index[next] );
+                }
+                continue;
+            }
+
+            // All edges done: close the component if node is its root, then return to the caller --
+
+            auto done = node;
+            frames.pop_back();
+            if ( lowLink[done] == index[done] ) {
+                Adjacency::Node member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    componentOfNode[member] = components;
+                } while ( member != done );
+                ++components;
+            }
+            if ( !frames.empty() ) {
+                auto caller = frames.back().first;
+                lowLink[caller] = min( lowLink[caller], lowLink[done] );
+            }
+        }
+    }
+    renumber( components );
+}
+
+void Components::weak( const Adjacency &graph, const Adjacency::Bits &edges ) {
+    uint32_t nodes = graph.node_count();
+    vector<uint32_t> parent( nodes );
+    for ( uint32_t node = 0; node < nodes; ++node ) {
+        parent[node] = node;
+    }
+    auto find = [&]( uint32_t node ) {
+        while ( parent[node] != node ) {
+            parent[node] = parent[parent[node]]; // Path halving
+            node = parent[node];
+        }
+        return node;
+    };
+
+    edges.for_each( [&]( uint32_t edge ) {
+        auto a = find( graph.source( edge ) );
+        auto b = find( graph.target( edge ) );
+        if ( a != b ) {
+            parent[max( a, b )] = min( a, b );
+        }
+    } );
+
+    componentOfNode.resize( nodes );
+    for ( uint32_t node = 0; node < nodes; ++node ) {
+        componentOfNode[node] = find( node );
+    }
+    renumber( nodes );
+}
+
+/**
+ * Numbers the components 0.. in the order of their first node and counts
+ * their nodes. components bounds the numbers in use so far.
+ */
+void Components::renumber( uint32_t components ) {
+    vector<uint32_t> number( components, UINT32_MAX );
+    nodeCount.clear();
+    for ( auto &component : componentOfNode ) {
+        if ( number[component] == UINT32_MAX ) {
+            number[component] = static_cast<uint32_t>( nodeCount.size() );
+            nodeCount.push_back( 0 );
+        }
+        component = number[component];
+        ++nodeCount[component];
+    }
+}
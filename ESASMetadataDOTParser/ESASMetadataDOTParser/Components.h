@@ -0,0 +1,60 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef Components_h
+#define Components_h
+
+#include "Adjacency.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Connected components of the nodes of an Adjacency over a subset of its
+ * edges, for --clusters and --split.
+ *
+ * Strong components come from Tarjan's algorithm with an explicit stack, so
+ * long chains of navigations cannot overflow the call stack. Weak
+ * components come from union-find over the edges. Either way components
+ * are numbered in the order of their first node.
+ */
+class Components {
+  public:
+    enum class Kind { Strong, Weak };
+
+    void compute( const Adjacency &graph, const Adjacency::Bits &edges, Kind kind );
+
+    uint32_t of( Adjacency::Node node ) const { return componentOfNode[node]; }
+    uint32_t count() const { return static_cast<uint32_t>( nodeCount.size() ); }
+    uint32_t size( uint32_t component ) const { return nodeCount[component]; } // In nodes
+
+  private:
+    void strong( const Adjacency &graph, const Adjacency::Bits &edges );
+    void weak( const Adjacency &graph, const Adjacency::Bits &edges );
+    void renumber( uint32_t components );
+
+    std::vector<uint32_t> componentOfNode;
+    std::vector<uint32_t> nodeCount;
+};
+
+#endif /* Components_h */
@@ -0,0 +1,74 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef ContentHash_h
+#define ContentHash_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+inline uint64_t hash_rotate_left( uint64_t value, int bits ) {
+    return ( value << bits ) | ( value >> ( 64 - bits ) );
+}
+
+/**
+ * Four independent multiply-rotate lanes over 8 byte words, so the loop is
+ * not bound by the latency of a single multiply chain. Fast enough to run
+ * over a whole input file on every start. Not cryptographic; it only has to
+ * tell versions of a file apart.
+ */
+inline uint64_t content_hash( const char *data, size_t size ) {
+    constexpr uint64_t Prime = 0x9E3779B97F4A7C15ull;
+    constexpr uint64_t Mix = 0xC2B2AE3D27D4EB4Full;
+    uint64_t lanes[4] = {Prime, Mix, Prime ^ Mix, Prime + Mix};
+
+    size_t i = 0;
+    for ( ; i + 4 * sizeof( uint64_t ) <= size; i += 4 * sizeof( uint64_t ) ) {
+        for ( size_t lane = 0; lane < 4; ++lane ) {
+            uint64_t word;
+            memcpy( &word, data + i + lane * sizeof( uint64_t ), sizeof( word ) );
+            lanes[lane] = hash_rotate_left( ( lanes[lane] ^ word ) * Mix, 31 ) * Prime;
+        }
+    }
+    for ( ; i < size; ++i ) {
+        lanes[0] = hash_rotate_left( ( lanes[0] ^ static_cast<unsigned char>( data[i] ) ) * Mix, 31 ) * Prime;
+    }
+
+    uint64_t hash = size * Prime;
+    for ( uint64_t lane : lanes ) {
+        hash = hash_rotate_left( hash ^ ( lane * Mix ), 27 ) * Prime + Mix;
+    }
+    hash ^= hash >> 33;
+    hash *= Mix;
+    return hash ^ ( hash >> 29 );
+}
+
+/**
+ * Folds value into the running hash seed, order sensitive.
+ */
+inline uint64_t hash_combine( uint64_t seed, uint64_t value ) {
+    return hash_rotate_left( seed ^ ( value * 0xC2B2AE3D27D4EB4Full ), 29 ) * 0x9E3779B97F4A7C15ull + value;
+}
+
+#endif /* ContentHash_h */
@@ -0,0 +1,61 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "DotWriter.h"
+
+using namespace std;
+
+DotWriter::DotWriter( ostream &stream, size_t blockSize ) : stream( stream ), blockSize( blockSize ) {
+
+    // Room for one block plus the element that crosses the block boundary --
+
+    pending.reserve( blockSize + blockSize / 4 );
+}
+
+DotWriter::~DotWriter() {
+    write();
+}
+
+void DotWriter::append( string_view elements ) {
+    if ( pending.size() + elements.size() < blockSize ) {
+        pending.append( elements );
+        return;
+    }
+    write();
+    stream.write( elements.data(), static_cast<streamsize>( elements.size() ) );
+    flushed += elements.size();
+}
+
+void DotWriter::finish() {
+    write();
+    stream.flush();
+}
+
+void DotWriter::write() {
+    if ( !pending.empty() ) {
+        stream.write( pending.data(), static_cast<streamsize>( pending.size() ) );
+        flushed += pending.size();
+        pending.clear();
+    }
+}
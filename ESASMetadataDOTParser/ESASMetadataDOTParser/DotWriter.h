@@ -0,0 +1,82 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef DotWriter_h
+#define DotWriter_h
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * Block buffered output for the DOT renderer.
+ *
+ * Elements are rendered straight into buffer(); commit() hands the buffer to
+ * the stream once it holds a full block, so the stream sees a few large
+ * writes instead of one flushed write per element, and at most one block of
+ * output is held in memory.
+ */
+class DotWriter {
+  public:
+    explicit DotWriter( std::ostream &stream, size_t blockSize = 1024 * 1024 );
+    ~DotWriter();
+
+    DotWriter( const DotWriter & ) = delete;
+    DotWriter &operator=( const DotWriter & ) = delete;
+
+    std::string &buffer() { return pending; }
+
+    // Bytes written so far, the buffered ones included --
+    uint64_t position() const { return flushed + pending.size(); }
+
+    // Call after each complete element --
+    void commit() {
+        if ( pending.size() >= blockSize ) {
+            write();
+        }
+    }
+
+    /**
+     * Adds a run of elements rendered elsewhere. Runs of a block or more go
+     * to the stream directly instead of through the buffer.
+     */
+    void append( std::string_view elements );
+
+    /**
+     * Writes what is buffered and flushes the stream.
+     */
+    void finish();
+
+  private:
+    void write();
+
+    std::ostream &stream;
+    size_t blockSize;
+    std::string pending;
+    uint64_t flushed = 0;
+};
+
+#endif /* DotWriter_h */
@@ -0,0 +1,176 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef EDM_h
+#define EDM_h
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+ * ALL THE BASIC EDM PROPERTIES
+ */
+
+struct EDMPropertyType {
+    static constexpr auto Edmx = std::string_view{"edmx:Edmx"};
+    static constexpr auto DataServices = std::string_view{"edmx:DataServices"};
+    static constexpr auto Schema = std::string_view{"Schema"};
+    static constexpr auto ComplexType = std::string_view{"ComplexType"};
+    static constexpr auto Property = std::string_view{"Property"};
+    static constexpr auto PropertyRef = std::string_view{"PropertyRef"};
+    static constexpr auto Key = std::string_view{"Key"};
+    static constexpr auto NavigationProperty = std::string_view{"NavigationProperty"};
+    static constexpr auto EntityType = std::string_view{"EntityType"};
+    static constexpr auto ReferentialConstraint = std::string_view{"ReferentialConstraint"};
+    static constexpr auto EntitySet = std::string_view{"EntitySet"};
+    static constexpr auto EntityContainer = std::string_view{"EntityContainer"};
+};
+
+/**
+ * ALL THE BASIC EDM ATTRIBUTES
+ */
+struct EDMAttributeType {
+    static constexpr auto Name = std::string_view{"Name"};
+    static constexpr auto Type = std::string_view{"Type"};
+    static constexpr auto Nullable = std::string_view{"Nullable"};
+    static constexpr auto ContainsTarget = std::string_view{"ContainsTarget"};
+    static constexpr auto ReferencedProperty = std::string_view{"ReferencedProperty"};
+    static constexpr auto EntityType = std::string_view{"EntityType"};
+    static constexpr auto Property = std::string_view{"Property"};
+    static constexpr auto Version = std::string_view{"Version"};
+    static constexpr auto Namespace = std::string_view{"Namespace"};
+    static constexpr auto Alias = std::string_view{"Alias"};
+};
+
+/**
+ * Compact ids for the names above, assigned by the parser through
+ * classify_edm_name(). Element and attribute names with the same spelling
+ * (EntityType, Property) share an id.
+ */
+enum class EDMName : uint8_t {
+    Unknown,
+    Edmx,
+    DataServices,
+    Schema,
+    ComplexType,
+    Property,
+    PropertyRef,
+    Key,
+    NavigationProperty,
+    EntityType,
+    ReferentialConstraint,
+    EntitySet,
+    EntityContainer,
+    Name,
+    Type,
+    Nullable,
+    ContainsTarget,
+    ReferencedProperty,
+    Version,
+    Namespace,
+    Alias,
+    Count
+};
+
+namespace edm {
+
+// Spelling of every EDMName, indexed by id --
+constexpr std::string_view names[] = {
+    {},
+    EDMPropertyType::Edmx,
+    EDMPropertyType::DataServices,
+    EDMPropertyType::Schema,
+    EDMPropertyType::ComplexType,
+    EDMPropertyType::Property,
+    EDMPropertyType::PropertyRef,
+    EDMPropertyType::Key,
+    EDMPropertyType::NavigationProperty,
+    EDMPropertyType::EntityType,
+    EDMPropertyType::ReferentialConstraint,
+    EDMPropertyType::EntitySet,
+    EDMPropertyType::EntityContainer,
+    EDMAttributeType::Name,
+    EDMAttributeType::Type,
+    EDMAttributeType::Nullable,
+    EDMAttributeType::ContainsTarget,
+    EDMAttributeType::ReferencedProperty,
+    EDMAttributeType::Version,
+    EDMAttributeType::Namespace,
+    EDMAttributeType::Alias,
+};
+static_assert( sizeof( names ) / sizeof( names[0] ) == static_cast<size_t>( EDMName::Count ), "names must list every EDMName" );
+
+constexpr size_t HashSize = 64;
+
+constexpr size_t hash_name( std::string_view name ) {
+    return ( name.size() + 3u * static_cast<unsigned char>( name[0] ) + static_cast<unsigned char>( name[name.size() / 2] ) ) % HashSize;
+}
+
+constexpr bool hash_is_perfect() {
+    for ( size_t i = 1; i < static_cast<size_t>( EDMName::Count ); ++i ) {
+        for ( size_t j = i + 1; j < static_cast<size_t>( EDMName::Count ); ++j ) {
+            if ( hash_name( names[i] ) == hash_name( names[j] ) ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+static_assert( hash_is_perfect(), "EDM names collide in hash_name(), adjust the hash" );
+
+constexpr std::array<EDMName, HashSize> build_table() {
+    std::array<EDMName, HashSize> table{};
+    for ( size_t i = 1; i < static_cast<size_t>( EDMName::Count ); ++i ) {
+        table[hash_name( names[i] )] = static_cast<EDMName>( i );
+    }
+    return table;
+}
+
+constexpr auto table = build_table();
+
+} // namespace edm
+
+/**
+ * Name classifier for tinyxml2::XMLDocument::SetNameClassifier and the
+ * streaming reader: one hash, one table load and one compare per name.
+ */
+inline int classify_edm_name( const char *name, size_t length ) {
+    if ( length == 0 ) {
+        return 0;
+    }
+    auto id = edm::table[edm::hash_name( std::string_view{name, length} )];
+    const auto &expected = edm::names[static_cast<size_t>( id )];
+    if ( id == EDMName::Unknown || expected.size() != length || memcmp( expected.data(), name, length ) != 0 ) {
+        return 0;
+    }
+    return static_cast<int>( id );
+}
+
+inline EDMName edm_name( int id ) {
+    return static_cast<EDMName>( id );
+}
+
+#endif /* EDM_h */
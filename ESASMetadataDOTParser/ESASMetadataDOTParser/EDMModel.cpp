@@ -0,0 +1,482 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "EDMModel.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+
+constexpr uint32_t Unknown = EDMModel::NoEntity - 1; // Type not looked up yet
+
+/**
+ * Replaces count values of to from at by the values first..last, passed
+ * through map.
+ */
+template <typename T, typename Iterator, typename Map>
+void splice( vector<T> &to, size_t at, size_t count, Iterator first, Iterator last, Map map ) {
+    size_t added = static_cast<size_t>( last - first );
+    if ( added > count ) {
+        to.insert( to.begin() + static_cast<ptrdiff_t>( at + count ), added - count, T{} );
+    } else {
+        to.erase( to.begin() + static_cast<ptrdiff_t>( at + added ), to.begin() + static_cast<ptrdiff_t>( at + count ) );
+    }
+    transform( first, last, to.begin() + static_cast<ptrdiff_t>( at ), map );
+}
+
+} // namespace
+
+EDMModel::Id EDMModel::add_schema( string_view schemaNamespace, string_view alias ) {
+    schemaNamespaces.push_back( strings.intern( schemaNamespace ) );
+    schemaAliases.push_back( alias.empty() ? StringTable::None : strings.intern( alias ) );
+    return schemaNamespaces.back();
+}
+
+uint32_t EDMModel::begin_entity( string_view name, Id schemaNamespace ) {
+    entityNames.push_back( strings.intern( name ) );
+    entityTypeNames.push_back( entityNames.back() );
+    entityNamespaces.push_back( schemaNamespace );
+    return entity_count() - 1;
+}
+
+void EDMModel::add_property( string_view name, string_view type ) {
+    propertyNames.push_back( strings.intern( name ) );
+    propertyTypes.push_back( strings.intern( type ) );
+}
+
+/**
+ * Sorts the properties of the open entity by name and drops all but the last
+ * declaration of each name. Works in the scratch vectors, so it allocates
+ * nothing once they have grown to the largest entity.
+ */
+void EDMModel::end_entity() {
+    uint32_t begin = entityProperties.back();
+    uint32_t end = static_cast<uint32_t>( propertyNames.size() );
+
+    // Ties go by row, which keeps declaration order without stable_sort's buffer --
+
+    propertyOrder.resize( end - begin );
+    iota( propertyOrder.begin(), propertyOrder.end(), begin );
+    sort( propertyOrder.begin(), propertyOrder.end(), [&]( uint32_t a, uint32_t b ) {
+        if ( propertyNames[a] == propertyNames[b] ) {
+            return a < b;
+        }
+        return strings[propertyNames[a]] < strings[propertyNames[b]];
+    } );
+
+    propertyRows.clear();
+    for ( size_t i = 0; i < propertyOrder.size(); ++i ) {
+        if ( i + 1 < propertyOrder.size() && propertyNames[propertyOrder[i]] == propertyNames[propertyOrder[i + 1]] ) {
+            continue;
+        }
+        propertyRows.push_back( static_cast<uint64_t>( propertyNames[propertyOrder[i]] ) << 32 | propertyTypes[propertyOrder[i]] );
+    }
+
+    propertyNames.resize( begin + propertyRows.size() );
+    propertyTypes.resize( begin + propertyRows.size() );
+    for ( size_t i = 0; i < propertyRows.size(); ++i ) {
+        propertyNames[begin + i] = static_cast<Id>( propertyRows[i] >> 32 );
+        propertyTypes[begin + i] = static_cast<Id>( propertyRows[i] );
+    }
+    entityProperties.push_back( static_cast<uint32_t>( propertyNames.size() ) );
+}
+
+void EDMModel::add_edge( uint32_t source, string_view sourceField, string_view targetType, string_view targetField ) {
+    string_view qualifier, name;
+    split_type( targetType, qualifier, name );
+
+    edgeSources.push_back( source );
+    edgeSourceFields.push_back( strings.intern( sourceField ) );
+    edgeTargets.push_back( strings.intern( name ) );
+    edgeTargetTypes.push_back( strings.intern( targetType ) );
+    edgeTargetRows.push_back( NoEntity );
+    edgeTargetFields.push_back( strings.intern( targetField ) );
+}
+
+void EDMModel::add_entity_set( string_view name, string_view type ) {
+    entitySetNames.push_back( strings.intern( name ) );
+    entitySetTypes.push_back( strings.intern( type ) );
+    entitySetRows.push_back( NoEntity );
+}
+
+void EDMModel::split_type( string_view type, string_view &qualifier, string_view &name ) {
+    constexpr auto collection = string_view{"Collection("};
+    if ( type.size() > collection.size() && type.compare( 0, collection.size(), collection ) == 0 && type.back() == ')' ) {
+        type = type.substr( collection.size(), type.size() - collection.size() - 1 );
+    }
+
+    size_t dot = type.rfind( '.' );
+    if ( dot == string_view::npos ) {
+        qualifier = {};
+        name = type;
+    } else {
+        qualifier = type.substr( 0, dot );
+        name = type.substr( dot + 1 );
+    }
+}
+
+uint32_t EDMModel::find_entity_type( string_view type ) const {
+    string_view qualifier, name;
+    split_type( type, qualifier, name );
+
+    Id qualifierId = strings.find( qualifier );
+    Id nameId = strings.find( name );
+    if ( qualifierId == StringTable::None || nameId == StringTable::None || qualifierId >= namespaceOfQualifier.size() ||
+         namespaceOfQualifier[qualifierId] == StringTable::None ) {
+        return NoEntity;
+    }
+
+    return entityIndex.empty() ? NoEntity : entityIndex[entity_slot( static_cast<uint64_t>( namespaceOfQualifier[qualifierId] ) << 32 | nameId )].second;
+}
+
+/**
+ * Returns the slot holding key, or the empty slot where it belongs.
+ */
+size_t EDMModel::entity_slot( uint64_t key ) const {
+    size_t mask = entityIndex.size() - 1;
+    for ( size_t slot = ( key * 0x9E3779B97F4A7C15ull ) >> 32 & mask;; slot = ( slot + 1 ) & mask ) {
+        if ( entityIndex[slot].second == NoEntity || entityIndex[slot].first == key ) {
+            return slot;
+        }
+    }
+}
+
+void EDMModel::resolve() {
+
+    // Symbol tables; ids are dense, so qualifiers index a plain vector --
+
+    namespaceOfQualifier.assign( strings.size(), StringTable::None );
+    for ( size_t schema = 0; schema < schemaNamespaces.size(); ++schema ) {
+        namespaceOfQualifier[schemaNamespaces[schema]] = schemaNamespaces[schema];
+        if ( schemaAliases[schema] != StringTable::None ) {
+            namespaceOfQualifier[schemaAliases[schema]] = schemaNamespaces[schema];
+        }
+    }
+
+    // Sized for a load factor of at most one half, so it never grows --
+
+    size_t slots = 16;
+    while ( slots < 2 * static_cast<size_t>( entity_count() ) ) {
+        slots *= 2;
+    }
+    entityIndex.assign( slots, {0, NoEntity} );
+    for ( uint32_t entity = 0; entity < entity_count(); ++entity ) {
+        if ( entityNamespaces[entity] != StringTable::None ) {
+            uint64_t key = static_cast<uint64_t>( entityNamespaces[entity] ) << 32 | entityTypeNames[entity];
+            auto &slot = entityIndex[entity_slot( key )];
+            if ( slot.second == NoEntity ) {
+                slot = {key, entity};
+            }
+        }
+    }
+
+    // EntitySets, counted per entity row --
+
+    vector<uint32_t> setCount( entity_count(), 0 );
+    vector<uint32_t> setOfEntity( entity_count(), 0 );
+    for ( uint32_t set = 0; set < entitySetNames.size(); ++set ) {
+        entitySetRows[set] = find_entity_type( strings[entitySetTypes[set]] );
+        if ( entitySetRows[set] != NoEntity ) {
+            ++setCount[entitySetRows[set]];
+            setOfEntity[entitySetRows[set]] = set;
+        }
+    }
+    for ( uint32_t entity = 0; entity < entity_count(); ++entity ) {
+        name_entity( entity, setCount, setOfEntity );
+    }
+
+    // Edge targets, every navigation type looked up once --
+
+    vector<uint32_t> rowOfType( strings.size(), Unknown );
+    for ( uint32_t edge = 0; edge < edge_count(); ++edge ) {
+        uint32_t &row = rowOfType[edgeTargetTypes[edge]];
+        if ( row == Unknown ) {
+            row = find_entity_type( strings[edgeTargetTypes[edge]] );
+        }
+        set_edge_target( edge, row );
+    }
+}
+
+void EDMModel::name_entity( uint32_t entity, const vector<uint32_t> &setCount, const vector<uint32_t> &setOfEntity ) {
+    entityNames[entity] = setCount[entity] == 1 ? entitySetNames[setOfEntity[entity]] : entityTypeNames[entity];
+}
+
+/**
+ * An unresolved edge points at the unqualified name of its type, which
+ * add_edge() has interned.
+ */
+void EDMModel::set_edge_target( uint32_t edge, uint32_t row ) {
+    edgeTargetRows[edge] = row;
+    if ( row != NoEntity ) {
+        edgeTargets[edge] = entityNames[row];
+    } else {
+        string_view qualifier, name;
+        split_type( strings[edgeTargetTypes[edge]], qualifier, name );
+        edgeTargets[edge] = strings.find( name );
+    }
+}
+
+void EDMModel::append( const EDMModel &other ) {
+    vector<Id> remap( other.strings.size() );
+    for ( Id id = 0; id < other.strings.size(); ++id ) {
+        remap[id] = strings.intern( other.strings[id] );
+    }
+
+    auto append_ids = [&]( vector<Id> &to, const vector<Id> &from ) {
+        if ( to.capacity() < to.size() + from.size() ) {
+            to.reserve( max( to.size() + from.size(), 2 * to.capacity() ) ); // Geometric, --watch merges thousands of chunks
+        }
+        for ( Id id : from ) {
+            to.push_back( remap[id] );
+        }
+    };
+
+    auto remap_optional = [&]( vector<Id> &to, const vector<Id> &from ) {
+        for ( Id id : from ) {
+            to.push_back( id != StringTable::None ? remap[id] : id );
+        }
+    };
+
+    append_ids( schemaNamespaces, other.schemaNamespaces );
+    remap_optional( schemaAliases, other.schemaAliases );
+
+    uint32_t entityBase = entity_count();
+    append_ids( entityNames, other.entityNames );
+    append_ids( entityTypeNames, other.entityTypeNames );
+    remap_optional( entityNamespaces, other.entityNamespaces );
+    uint32_t base = static_cast<uint32_t>( propertyNames.size() );
+    for ( size_t i = 1; i < other.entityProperties.size(); ++i ) {
+        entityProperties.push_back( base + other.entityProperties[i] );
+    }
+    append_ids( propertyNames, other.propertyNames );
+    append_ids( propertyTypes, other.propertyTypes );
+    for ( uint32_t source : other.edgeSources ) {
+        edgeSources.push_back( entityBase + source );
+    }
+    append_ids( edgeSourceFields, other.edgeSourceFields );
+    append_ids( edgeTargets, other.edgeTargets );
+    append_ids( edgeTargetTypes, other.edgeTargetTypes );
+    for ( uint32_t row : other.edgeTargetRows ) {
+        edgeTargetRows.push_back( row != NoEntity ? entityBase + row : row );
+    }
+    append_ids( edgeTargetFields, other.edgeTargetFields );
+    append_ids( entitySetNames, other.entitySetNames );
+    append_ids( entitySetTypes, other.entitySetTypes );
+    for ( uint32_t row : other.entitySetRows ) {
+        entitySetRows.push_back( row != NoEntity ? entityBase + row : row );
+    }
+}
+
+void EDMModel::replace( const Rows &at, const Rows &count, const EDMModel &other, Changes &changes ) {
+    changes.renamed.clear();
+    changes.retargeted.clear();
+    bool resolved = !entityIndex.empty();
+    Rows added = other.rows();
+
+    // The symbol tables hold as long as the same Schemas and EntityTypes come back --
+
+    auto same = [&]( Id ours, Id theirs ) {
+        return ours == StringTable::None ? theirs == StringTable::None : theirs != StringTable::None && strings[ours] == other.strings[theirs];
+    };
+    bool sameTypes = added.entities == count.entities;
+    for ( uint32_t i = 0; sameTypes && i < added.entities; ++i ) {
+        sameTypes = same( entityNamespaces[at.entities + i], other.entityNamespaces[i] ) && same( entityTypeNames[at.entities + i], other.entityTypeNames[i] );
+    }
+    if ( sameTypes ) {
+
+        // Every chunk repeats its Schema, so only the distinct ones count --
+
+        vector<pair<string_view, string_view>> removedSchemas;
+        vector<pair<string_view, string_view>> addedSchemas;
+        auto text = []( const EDMModel &model, Id id ) { return id != StringTable::None ? model.strings[id] : string_view{}; };
+        for ( uint32_t i = 0; i < count.schemas; ++i ) {
+            removedSchemas.emplace_back( strings[schemaNamespaces[at.schemas + i]], text( *this, schemaAliases[at.schemas + i] ) );
+        }
+        for ( uint32_t i = 0; i < added.schemas; ++i ) {
+            addedSchemas.emplace_back( other.strings[other.schemaNamespaces[i]], text( other, other.schemaAliases[i] ) );
+        }
+        for ( auto *schemas : {&removedSchemas, &addedSchemas} ) {
+            sort( schemas->begin(), schemas->end() );
+            schemas->erase( unique( schemas->begin(), schemas->end() ), schemas->end() );
+        }
+        sameTypes = removedSchemas == addedSchemas;
+    }
+
+    // What the kept rows were resolved to, to tell what changed --
+
+    vector<Id> oldNames;
+    vector<Id> oldTargets;
+    vector<uint32_t> oldTargetRows;
+    vector<uint32_t> oldSetRows;
+    if ( resolved && sameTypes ) {
+        oldNames.assign( entityNames.begin() + at.entities, entityNames.begin() + at.entities + count.entities );
+        oldSetRows.assign( entitySetRows.begin() + at.entitySets, entitySetRows.begin() + at.entitySets + count.entitySets );
+    } else if ( resolved ) {
+        oldNames = entityNames;
+        oldTargets = edgeTargets;
+        oldTargetRows = edgeTargetRows;
+    }
+
+    // Splice; the rows of other are numbered from zero --
+
+    vector<Id> remap( other.strings.size() );
+    for ( Id id = 0; id < other.strings.size(); ++id ) {
+        remap[id] = strings.intern( other.strings[id] );
+    }
+    auto id = [&]( Id id ) { return remap[id]; };
+    auto optional = [&]( Id id ) { return id != StringTable::None ? remap[id] : id; };
+    auto entity = [&]( uint32_t row ) { return row != NoEntity ? at.entities + row : row; };
+
+    splice( schemaNamespaces, at.schemas, count.schemas, other.schemaNamespaces.begin(), other.schemaNamespaces.end(), id );
+    splice( schemaAliases, at.schemas, count.schemas, other.schemaAliases.begin(), other.schemaAliases.end(), optional );
+
+    uint32_t propertiesBegin = entityProperties[at.entities];
+    uint32_t propertiesEnd = entityProperties[at.entities + count.entities];
+    splice( propertyNames, propertiesBegin, propertiesEnd - propertiesBegin, other.propertyNames.begin(), other.propertyNames.end(), id );
+    splice( propertyTypes, propertiesBegin, propertiesEnd - propertiesBegin, other.propertyTypes.begin(), other.propertyTypes.end(), id );
+    splice( entityProperties, at.entities + 1, count.entities, other.entityProperties.begin() + 1, other.entityProperties.end(),
+            [&]( uint32_t offset ) { return propertiesBegin + offset; } );
+    for ( size_t i = at.entities + added.entities + 1; i < entityProperties.size(); ++i ) {
+        entityProperties[i] = entityProperties[i] - propertiesEnd + propertiesBegin + static_cast<uint32_t>( other.propertyNames.size() );
+    }
+
+    splice( entityNames, at.entities, count.entities, other.entityNames.begin(), other.entityNames.end(), id );
+    splice( entityTypeNames, at.entities, count.entities, other.entityTypeNames.begin(), other.entityTypeNames.end(), id );
+    splice( entityNamespaces, at.entities, count.entities, other.entityNamespaces.begin(), other.entityNamespaces.end(), optional );
+
+    splice( edgeSources, at.edges, count.edges, other.edgeSources.begin(), other.edgeSources.end(), entity );
+    splice( edgeSourceFields, at.edges, count.edges, other.edgeSourceFields.begin(), other.edgeSourceFields.end(), id );
+    splice( edgeTargets, at.edges, count.edges, other.edgeTargets.begin(), other.edgeTargets.end(), id );
+    splice( edgeTargetTypes, at.edges, count.edges, other.edgeTargetTypes.begin(), other.edgeTargetTypes.end(), id );
+    splice( edgeTargetRows, at.edges, count.edges, other.edgeTargetRows.begin(), other.edgeTargetRows.end(), entity );
+    splice( edgeTargetFields, at.edges, count.edges, other.edgeTargetFields.begin(), other.edgeTargetFields.end(), id );
+    if ( added.entities != count.entities ) {
+        for ( size_t edge = at.edges + added.edges; edge < edgeSources.size(); ++edge ) {
+            edgeSources[edge] = edgeSources[edge] - count.entities + added.entities;
+        }
+    }
+
+    splice( entitySetNames, at.entitySets, count.entitySets, other.entitySetNames.begin(), other.entitySetNames.end(), id );
+    splice( entitySetTypes, at.entitySets, count.entitySets, other.entitySetTypes.begin(), other.entitySetTypes.end(), id );
+    splice( entitySetRows, at.entitySets, count.entitySets, other.entitySetRows.begin(), other.entitySetRows.end(), entity );
+
+    if ( !resolved ) {
+        return;
+    }
+
+    if ( !sameTypes ) {
+
+        // Rows move, so everything is resolved again and compared row by row --
+
+        resolve();
+        auto kept = [&]( uint32_t row, uint32_t begin, uint32_t removed, uint32_t inserted ) {
+            return row < begin ? row : ( row >= begin + removed ? row - removed + inserted : NoEntity );
+        };
+        for ( uint32_t row = 0; row < oldNames.size(); ++row ) {
+            uint32_t now = kept( row, at.entities, count.entities, added.entities );
+            if ( now != NoEntity && entityNames[now] != oldNames[row] ) {
+                changes.renamed.push_back( now );
+            }
+        }
+        for ( uint32_t edge = 0; edge < oldTargets.size(); ++edge ) {
+            uint32_t now = kept( edge, at.edges, count.edges, added.edges );
+            if ( now != NoEntity &&
+                 ( edgeTargets[now] != oldTargets[edge] || ( edgeTargetRows[now] == NoEntity ) != ( oldTargetRows[edge] == NoEntity ) ) ) {
+                changes.retargeted.push_back( now );
+            }
+        }
+        return;
+    }
+
+    // Entity rows stay where they were; the new EntitySets and those they replace name entities again --
+
+    vector<uint32_t> touched;
+    for ( uint32_t row : oldSetRows ) {
+        if ( row != NoEntity ) {
+            touched.push_back( row );
+        }
+    }
+    for ( uint32_t set = at.entitySets; set < at.entitySets + added.entitySets; ++set ) {
+        entitySetRows[set] = find_entity_type( strings[entitySetTypes[set]] );
+        if ( entitySetRows[set] != NoEntity ) {
+            touched.push_back( entitySetRows[set] );
+        }
+    }
+    for ( uint32_t row = at.entities; row < at.entities + added.entities; ++row ) {
+        touched.push_back( row );
+    }
+    sort( touched.begin(), touched.end() );
+    touched.erase( unique( touched.begin(), touched.end() ), touched.end() );
+
+    vector<uint32_t> setCount( entity_count(), 0 );
+    vector<uint32_t> setOfEntity( entity_count(), 0 );
+    for ( uint32_t set = 0; set < entitySetRows.size(); ++set ) {
+        if ( entitySetRows[set] != NoEntity ) {
+            ++setCount[entitySetRows[set]];
+            setOfEntity[entitySetRows[set]] = set;
+        }
+    }
+    vector<bool> renamed( entity_count(), false );
+    bool anyRenamed = false;
+    for ( uint32_t row : touched ) {
+        bool inserted = row >= at.entities && row < at.entities + added.entities;
+        Id before = inserted ? oldNames[row - at.entities] : entityNames[row];
+        name_entity( row, setCount, setOfEntity );
+        if ( entityNames[row] != before ) {
+            renamed[row] = anyRenamed = true;
+            if ( !inserted ) {
+                changes.renamed.push_back( row );
+            }
+        }
+    }
+
+    // New edges are resolved, kept ones follow their target's name --
+
+    for ( uint32_t edge = at.edges; edge < at.edges + added.edges; ++edge ) {
+        set_edge_target( edge, find_entity_type( strings[edgeTargetTypes[edge]] ) );
+    }
+    auto follow = [&]( uint32_t begin, uint32_t end ) {
+        for ( uint32_t edge = begin; edge < end; ++edge ) {
+            uint32_t row = edgeTargetRows[edge];
+            if ( row != NoEntity && renamed[row] ) {
+                edgeTargets[edge] = entityNames[row];
+                changes.retargeted.push_back( edge );
+            }
+        }
+    };
+    if ( anyRenamed ) {
+        follow( 0, at.edges );
+        follow( at.edges + added.edges, edge_count() );
+    }
+}
+
+size_t EDMModel::memoryUsage() const {
+    size_t rows = schemaNamespaces.capacity() + schemaAliases.capacity() + entityNames.capacity() + entityTypeNames.capacity() + entityNamespaces.capacity() + entityProperties.capacity() + propertyNames.capacity() + propertyTypes.capacity() +
+                  edgeSources.capacity() + edgeSourceFields.capacity() + edgeTargets.capacity() + edgeTargetTypes.capacity() + edgeTargetRows.capacity() + edgeTargetFields.capacity() +
+                  entitySetNames.capacity() + entitySetTypes.capacity() + entitySetRows.capacity();
+    return strings.memoryUsage() + rows * sizeof( uint32_t ) + namespaceOfQualifier.capacity() * sizeof( Id ) +
+           entityIndex.capacity() * sizeof( entityIndex[0] );
+}
@@ -0,0 +1,199 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef EDMModel_h
+#define EDMModel_h
+
+#include "StringTable.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * The extracted EDM model. All names are interned in strings and every
+ * record is a row across parallel vectors, addressed by its 32 bit index.
+ *
+ * Entities keep document order. The properties of entity i are the rows
+ * properties( i ), sorted by name with one row per name (a later
+ * declaration replaces an earlier one). Edges are the ReferentialConstraints
+ * of navigation properties; the source is an entity row and the target is
+ * the name of the entity the navigation type refers to.
+ */
+struct EDMModel {
+    typedef StringTable::Id Id;
+    static constexpr uint32_t NoEntity = UINT32_MAX;
+
+    struct Range {
+        uint32_t begin;
+        uint32_t end;
+        uint32_t size() const { return end - begin; }
+    };
+
+    StringTable strings;
+
+    // Schemas --
+    std::vector<Id> schemaNamespaces;
+    std::vector<Id> schemaAliases; // None for a Schema without Alias
+
+    // Entities --
+    std::vector<Id> entityNames;     // Name shown, the EntitySet name after resolve()
+    std::vector<Id> entityTypeNames; // Name as declared
+    std::vector<Id> entityNamespaces;
+    std::vector<uint32_t> entityProperties{0}; // Entities + 1 entries
+
+    // Properties --
+    std::vector<Id> propertyNames;
+    std::vector<Id> propertyTypes;
+
+    // Navigation edges --
+    std::vector<uint32_t> edgeSources; // Declaring entity row
+    std::vector<Id> edgeSourceFields;  // Property of the constraint
+    std::vector<Id> edgeTargets;          // Target entity name
+    std::vector<Id> edgeTargetTypes;      // Type of the navigation property as written
+    std::vector<uint32_t> edgeTargetRows; // Target entity row, NoEntity until resolve() or if undeclared
+    std::vector<Id> edgeTargetFields;     // ReferencedProperty of the constraint
+
+    // EntitySets --
+    std::vector<Id> entitySetNames;
+    std::vector<Id> entitySetTypes;
+    std::vector<uint32_t> entitySetRows; // Entity row of the type, NoEntity until resolve() or if undeclared
+
+    /**
+     * A row of every table, or a number of rows of every table. The
+     * properties go with their entities.
+     */
+    struct Rows {
+        uint32_t schemas = 0;
+        uint32_t entities = 0;
+        uint32_t edges = 0;
+        uint32_t entitySets = 0;
+
+        Rows &operator+=( const Rows &other ) {
+            schemas += other.schemas;
+            entities += other.entities;
+            edges += other.edges;
+            entitySets += other.entitySets;
+            return *this;
+        }
+    };
+
+    /**
+     * What replace() changed in the rows it kept.
+     */
+    struct Changes {
+        std::vector<uint32_t> renamed;    // Entity rows that are shown under another name
+        std::vector<uint32_t> retargeted; // Edge rows with another target, or that were or are now unresolved
+    };
+
+    uint32_t entity_count() const { return static_cast<uint32_t>( entityNames.size() ); }
+    uint32_t edge_count() const { return static_cast<uint32_t>( edgeSources.size() ); }
+    Range properties( uint32_t entity ) const { return {entityProperties[entity], entityProperties[entity + 1]}; }
+    Id edge_source_name( uint32_t edge ) const { return entityNames[edgeSources[edge]]; }
+    Rows rows() const { return {static_cast<uint32_t>( schemaNamespaces.size() ), entity_count(), edge_count(), static_cast<uint32_t>( entitySetNames.size() )}; }
+
+    /**
+     * Builder. Properties added between begin_entity() and end_entity()
+     * belong to that entity.
+     */
+    Id add_schema( std::string_view schemaNamespace, std::string_view alias );
+    uint32_t begin_entity( std::string_view name, Id schemaNamespace );
+    void add_property( std::string_view name, std::string_view type );
+    void end_entity();
+    void add_edge( uint32_t source, std::string_view sourceField, std::string_view targetType, std::string_view targetField );
+    void add_entity_set( std::string_view name, std::string_view type );
+
+    /**
+     * Runs once the whole document is read:
+     *  - builds the symbol tables below,
+     *  - resolves every edge to the entity row of its navigation type,
+     *  - names every entity that is the type of exactly one EntitySet after
+     *    that set; types with several sets keep their type name.
+     * Each step is one pass with hash lookups, no strings are built, and
+     * every navigation type is looked up once. Running it again resolves
+     * from scratch.
+     */
+    void resolve();
+
+    /**
+     * Entity row of a type reference, "Namespace.Name" or "Alias.Name",
+     * optionally wrapped in Collection(). NoEntity if it is not declared.
+     * Needs the symbol tables built by resolve().
+     */
+    uint32_t find_entity_type( std::string_view type ) const;
+
+    /**
+     * Splits a type reference into qualifier and unqualified name, dropping
+     * a Collection() wrapper.
+     */
+    static void split_type( std::string_view type, std::string_view &qualifier, std::string_view &name );
+
+    /**
+     * Appends all rows of other, re-interning its names into our table.
+     */
+    void append( const EDMModel &other );
+
+    /**
+     * Replaces count rows of every table, starting at rows at, by all rows
+     * of other, which must not be resolved; for --watch. Only the strings of
+     * other are interned, and the rows after the replaced ones move.
+     *
+     * A resolved model stays resolved. As long as the Schemas and the
+     * EntityTypes replaced are the same as the new ones, only the new rows
+     * are resolved and only the entities their EntitySets name again, with
+     * the edges to those, are touched. Otherwise everything is resolved
+     * again. Either way changes lists the kept rows that changed.
+     */
+    void replace( const Rows &at, const Rows &count, const EDMModel &other, Changes &changes );
+
+    /**
+     * Where a row of a table is after replace() put added rows from begin in
+     * place of removed ones, and where a row was before it; NoEntity for the
+     * replaced rows.
+     */
+    static uint32_t row_after( uint32_t row, uint32_t begin, uint32_t removed, uint32_t added ) {
+        return row < begin ? row : ( row >= begin + removed ? row - removed + added : NoEntity );
+    }
+    static uint32_t row_before( uint32_t row, uint32_t begin, uint32_t removed, uint32_t added ) {
+        return row_after( row, begin, added, removed );
+    }
+
+    size_t memoryUsage() const;
+
+    // Symbol tables --
+    std::vector<Id> namespaceOfQualifier;                    // Namespace or Alias id -> Namespace id
+    std::vector<std::pair<uint64_t, uint32_t>> entityIndex; // Open addressing, Namespace id << 32 | name id -> first entity row
+
+  private:
+    size_t entity_slot( uint64_t key ) const;
+    void set_edge_target( uint32_t edge, uint32_t row );
+    void name_entity( uint32_t entity, const std::vector<uint32_t> &setCount, const std::vector<uint32_t> &setOfEntity );
+
+    // Scratch for end_entity(), kept so its capacity is reused --
+    std::vector<uint32_t> propertyOrder;
+    std::vector<uint64_t> propertyRows;
+};
+
+#endif /* EDMModel_h */
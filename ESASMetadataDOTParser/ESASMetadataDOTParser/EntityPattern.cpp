@@ -0,0 +1,118 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "EntityPattern.h"
+#include <algorithm>
+
+using namespace std;
+
+EntityPattern::EntityPattern( Kind kind, string text ) : patternKind( kind ), pattern( move( text ) ) {
+}
+
+bool EntityPattern::parse_list( string_view list, vector<EntityPattern> &patterns, string &error ) {
+    while ( !list.empty() ) {
+        // A regular expression may contain commas, so it runs to the first unescaped / that ends the list or an item --
+
+        if ( list.front() == '/' ) {
+            size_t end = 1;
+            while ( end < list.size() && !( list[end] == '/' && ( end + 1 == list.size() || list[end + 1] == ',' ) ) ) {
+                end += list[end] == '\\' ? 2 : 1;
+            }
+            if ( end >= list.size() ) {
+                error = "Unterminated regular expression " + string{list};
+                return false;
+            }
+            auto item = list.substr( 0, end + 1 );
+            list = list.substr( min( end + 2, list.size() ) );
+            if ( item.size() == 2 ) {
+                error = "Empty regular expression //";
+                return false;
+            }
+
+            EntityPattern regex( Kind::Regex, string{item.substr( 1, item.size() - 2 )} );
+            try {
+                regex.expression = make_shared<const std::regex>( regex.pattern, regex::ECMAScript | regex::optimize );
+            } catch ( const regex_error &exception ) {
+                error = "Invalid regular expression " + string{item} + ": " + exception.what();
+                return false;
+            }
+            patterns.push_back( move( regex ) );
+            continue;
+        }
+
+        auto comma = list.find( ',' );
+        auto item = list.substr( 0, comma );
+        list = comma == string_view::npos ? string_view{} : list.substr( comma + 1 );
+        if ( item.empty() ) {
+            continue;
+        }
+
+        if ( item.find_first_of( "*?" ) != string_view::npos ) {
+            patterns.push_back( EntityPattern( Kind::Glob, string{item} ) );
+        } else {
+            patterns.push_back( EntityPattern( Kind::Name, string{item} ) );
+        }
+    }
+    return true;
+}
+
+bool EntityPattern::matches( string_view name ) const {
+    switch ( patternKind ) {
+    case Kind::Glob:
+        return glob_match( pattern, name );
+    case Kind::Regex:
+        return regex_search( name.begin(), name.end(), *expression );
+    default:
+        return name == pattern;
+    }
+}
+
+/**
+ * Matches the whole name. A mismatch after a * goes back to just past
+ * that star only, so this is linear in practice and never recurses.
+ */
+bool EntityPattern::glob_match( string_view glob, string_view name ) {
+    size_t g = 0;
+    size_t n = 0;
+    size_t star = string_view::npos;
+    size_t resume = 0;
+    while ( n < name.size() ) {
+        if ( g < glob.size() && ( glob[g] == '?' || glob[g] == name[n] ) ) {
+            ++g;
+            ++n;
+        } else if ( g < glob.size() && glob[g] == '*' ) {
+            star = g++;
+            resume = n;
+        } else if ( star != string_view::npos ) {
+            g = star + 1;
+            n = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while ( g < glob.size() && glob[g] == '*' ) {
+        ++g;
+    }
+    return g == glob.size();
+}
@@ -0,0 +1,66 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef EntityPattern_h
+#define EntityPattern_h
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * One center entity argument: an exact name, a glob with * and ? such as
+ * Ansoeg*, or a regular expression between slashes such as /^Ansoeg.+/.
+ * Compiled once and then matched against every entity name of the model.
+ */
+class EntityPattern {
+  public:
+    enum class Kind { Name, Glob, Regex };
+
+    /**
+     * Parses a comma separated list of patterns and appends them to
+     * patterns. A regular expression ends at the first unescaped / followed
+     * by a comma or the end, so /A{1,3}/ stays whole. False with error set
+     * if a regular expression is unterminated, empty or invalid.
+     */
+    static bool parse_list( std::string_view list, std::vector<EntityPattern> &patterns, std::string &error );
+
+    Kind kind() const { return patternKind; }
+    const std::string &text() const { return pattern; } // The name for Kind::Name
+
+    bool matches( std::string_view name ) const;
+
+  private:
+    EntityPattern( Kind kind, std::string text );
+
+    static bool glob_match( std::string_view glob, std::string_view name );
+
+    Kind patternKind;
+    std::string pattern;
+    std::shared_ptr<const std::regex> expression;
+};
+
+#endif /* EntityPattern_h */
@@ -0,0 +1,193 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "FileWatcher.h"
+#include <chrono>
+#include <system_error>
+#include <thread>
+
+#if defined( __linux__ )
+#define HAS_INOTIFY
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined( __APPLE__ )
+#define HAS_KQUEUE
+#include <fcntl.h>
+#include <sys/event.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace filesystem;
+
+namespace {
+
+constexpr int PollInterval = 50;   // Milliseconds between checks without events
+constexpr int EventTimeout = 1000; // Milliseconds between checks with events, in case one is missed
+constexpr int SettleTime = 20;     // Milliseconds the file must stay unchanged before it is read, unless its writer has closed it
+
+string directory_of( const string &fileName ) {
+    auto parent = path( fileName ).parent_path();
+    return parent.empty() ? string{"."} : parent.string();
+}
+
+} // namespace
+
+FileWatcher::FileWatcher( string fileName ) : fileName( move( fileName ) ), last( signature() ) {
+#if defined( HAS_INOTIFY )
+    events = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( events >= 0 ) {
+        directoryWatch = inotify_add_watch( events, directory_of( this->fileName ).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE );
+    }
+#elif defined( HAS_KQUEUE )
+    events = kqueue();
+    if ( events >= 0 ) {
+        directoryWatch = open( directory_of( this->fileName ).c_str(), O_EVTONLY );
+        if ( directoryWatch >= 0 ) {
+            struct kevent change;
+            EV_SET( &change, directoryWatch, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_WRITE, 0, nullptr );
+            kevent( events, &change, 1, nullptr, 0, nullptr );
+        }
+    }
+#endif
+    watch_file();
+}
+
+FileWatcher::~FileWatcher() {
+#if defined( HAS_KQUEUE )
+    if ( fileWatch >= 0 ) {
+        close( fileWatch );
+    }
+    if ( directoryWatch >= 0 ) {
+        close( directoryWatch );
+    }
+#endif
+#if defined( HAS_INOTIFY ) || defined( HAS_KQUEUE )
+    if ( events >= 0 ) {
+        close( events );
+    }
+#endif
+}
+
+FileWatcher::Signature FileWatcher::signature() const {
+    Signature result;
+    error_code error;
+    result.time = last_write_time( fileName, error );
+    if ( !error ) {
+        result.size = file_size( fileName, error );
+        result.exists = !error;
+    }
+    return result;
+}
+
+/**
+ * Watches the file as it is now; after a replace the old watch is on a file
+ * that is gone.
+ */
+void FileWatcher::watch_file() {
+#if defined( HAS_INOTIFY )
+    if ( events >= 0 ) {
+        if ( fileWatch >= 0 ) {
+            inotify_rm_watch( events, fileWatch );
+        }
+        fileWatch = inotify_add_watch( events, fileName.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF );
+    }
+#elif defined( HAS_KQUEUE )
+    if ( events >= 0 ) {
+        if ( fileWatch >= 0 ) {
+            close( fileWatch ); // Also removes its event
+        }
+        fileWatch = open( fileName.c_str(), O_EVTONLY );
+        if ( fileWatch >= 0 ) {
+            struct kevent change;
+            EV_SET( &change, fileWatch, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_WRITE | NOTE_EXTEND | NOTE_ATTRIB | NOTE_DELETE | NOTE_RENAME, 0, nullptr );
+            kevent( events, &change, 1, nullptr, 0, nullptr );
+        }
+    }
+#endif
+}
+
+/**
+ * Returns after an event or after milliseconds, whichever comes first. True
+ * if an event says the file was closed after writing or renamed into place,
+ * so its writer is done; only inotify tells.
+ */
+bool FileWatcher::sleep_for_events( int milliseconds ) {
+#if defined( HAS_INOTIFY )
+    if ( events >= 0 ) {
+        bool finished = false;
+        pollfd ready{events, POLLIN, 0};
+        if ( poll( &ready, 1, milliseconds ) > 0 ) {
+            auto name = path( fileName ).filename().string();
+            alignas( inotify_event ) char buffer[4096];
+            for ( ssize_t length; ( length = read( events, buffer, sizeof( buffer ) ) ) > 0; ) {
+                for ( ssize_t offset = 0; offset < length; ) {
+                    const auto *event = reinterpret_cast<const inotify_event *>( buffer + offset );
+                    if ( ( event->mask & ( IN_CLOSE_WRITE | IN_MOVED_TO ) ) != 0 &&
+                         ( event->wd == fileWatch || ( event->len > 0 && name == event->name ) ) ) {
+                        finished = true;
+                    }
+                    offset += static_cast<ssize_t>( sizeof( inotify_event ) + event->len );
+                }
+            }
+        }
+        return finished;
+    }
+#elif defined( HAS_KQUEUE )
+    if ( events >= 0 ) {
+        struct kevent event;
+        timespec timeout{milliseconds / 1000, ( milliseconds % 1000 ) * 1000000L};
+        kevent( events, nullptr, 0, &event, 1, &timeout );
+        return false;
+    }
+#endif
+    this_thread::sleep_for( chrono::milliseconds( milliseconds ) );
+    return false;
+}
+
+void FileWatcher::wait() {
+    for ( ;; ) {
+        bool finished = sleep_for_events( events >= 0 ? EventTimeout : PollInterval );
+        Signature current = signature();
+        if ( current == last || !current.exists ) {
+            continue;
+        }
+
+        // Wait for the writer to finish, unless it said so --
+
+        for ( Signature settled = current; !finished; settled = current ) {
+            finished = sleep_for_events( SettleTime );
+            current = signature();
+            if ( current == settled ) {
+                break;
+            }
+        }
+        if ( current.exists ) {
+            last = current;
+            watch_file();
+            return;
+        }
+    }
+}
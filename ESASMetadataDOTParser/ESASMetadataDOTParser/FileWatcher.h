@@ -0,0 +1,78 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef FileWatcher_h
+#define FileWatcher_h
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/**
+ * Waits for changes to one file, for --watch.
+ *
+ * Uses inotify on Linux and kqueue on macOS, and polls elsewhere. Events
+ * only wake the watcher up; a change is the modification time or size of
+ * the file differing from the last one seen. The directory is watched as
+ * well, so editors that save by renaming a new file over the old one are
+ * noticed. The file counts as saved as soon as inotify reports it closed
+ * after writing or renamed into place, and otherwise once it has stayed the
+ * same for a moment.
+ */
+class FileWatcher {
+  public:
+    explicit FileWatcher( std::string fileName );
+    ~FileWatcher();
+
+    FileWatcher( const FileWatcher & ) = delete;
+    FileWatcher &operator=( const FileWatcher & ) = delete;
+
+    /**
+     * Blocks until the file has changed since the last call, or since the
+     * watcher was made, and its writer is done with it, so a save in
+     * progress is not read half written.
+     */
+    void wait();
+
+  private:
+    struct Signature {
+        std::filesystem::file_time_type time;
+        uintmax_t size = 0;
+        bool exists = false;
+
+        bool operator==( const Signature &other ) const { return exists == other.exists && time == other.time && size == other.size; }
+        bool operator!=( const Signature &other ) const { return !( *this == other ); }
+    };
+
+    Signature signature() const;
+    void watch_file();
+    bool sleep_for_events( int milliseconds );
+
+    std::string fileName;
+    Signature last;
+    int events = -1;   // inotify instance or kqueue, -1 when polling
+    int fileWatch = -1; // Watch on the file itself, renewed when it is replaced
+    int directoryWatch = -1;
+};
+
+#endif /* FileWatcher_h */
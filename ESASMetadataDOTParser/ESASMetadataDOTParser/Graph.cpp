@@ -0,0 +1,754 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#include "Graph.h"
+#include "DotWriter.h"
+#include "EDM.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <tuple>
+
+using namespace std;
+using namespace tinyxml2;
+
+namespace {
+
+/**
+ * Three way compare of left + ":" + leftField against right + ":" + rightField
+ * without building either string. Arrows are ordered this way.
+ */
+int compare_joined( string_view left, string_view leftField, string_view right, string_view rightField ) {
+    size_t leftLength = left.size() + 1 + leftField.size();
+    size_t rightLength = right.size() + 1 + rightField.size();
+    auto at = []( string_view first, string_view second, size_t i ) -> unsigned char {
+        if ( i < first.size() ) {
+            return static_cast<unsigned char>( first[i] );
+        }
+        return i == first.size() ? ':' : static_cast<unsigned char>( second[i - first.size() - 1] );
+    };
+
+    for ( size_t i = 0, length = min( leftLength, rightLength ); i < length; ++i ) {
+        unsigned char l = at( left, leftField, i );
+        unsigned char r = at( right, rightField, i );
+        if ( l != r ) {
+            return l < r ? -1 : 1;
+        }
+    }
+    return leftLength < rightLength ? -1 : ( leftLength > rightLength ? 1 : 0 );
+}
+
+} // namespace
+
+void Graph::begin_schema( string_view schemaNamespace, string_view alias ) {
+    currentNamespace = edm.add_schema( schemaNamespace, alias );
+    resolved = false;
+    ++modelRevision;
+}
+
+void Graph::begin_entity_type( string_view name ) {
+    currentEntity = edm.begin_entity( name, currentNamespace );
+    indexed = false;
+    resolved = false;
+    ++modelRevision;
+}
+
+void Graph::add_property( string_view name, string_view type ) {
+    edm.add_property( name, type );
+}
+
+void Graph::add_referential_constraint( string_view type, string_view property, string_view referencedProperty ) {
+    edm.add_edge( currentEntity, property, type, referencedProperty );
+    indexed = false;
+}
+
+void Graph::end_entity_type() {
+    edm.end_entity();
+}
+
+void Graph::add_entity( string_view name, string_view type ) {
+    edm.add_entity_set( name, type );
+    resolved = false;
+    ++modelRevision;
+}
+
+void Graph::resolve() {
+    if ( resolved ) {
+        return;
+    }
+    edm.resolve();
+    resolved = true;
+    indexed = false;
+    ++modelRevision;
+}
+
+void Graph::assign( EDMModel &&model ) {
+    edm = move( model );
+    resolved = true;
+    indexed = false;
+    filtered = false;
+    tableClusters.clear();
+    ++modelRevision;
+}
+
+void Graph::replace( const EDMModel::Rows &at, const EDMModel::Rows &count, Graph &&other ) {
+    replaced.at = at;
+    replaced.removed = count;
+    replaced.added = other.edm.rows();
+    edm.replace( at, count, other.edm, replaced.changes );
+    other.edm = EDMModel{};
+    replaced.revision = ++modelRevision;
+
+    indexed = false;
+    filtered = false;
+    tables.clear();
+    edges.clear();
+    tableClusters.clear();
+}
+
+void open_table( string &out, string_view name, const TableStyle &style ) {
+    append_to_string( out, name,
+
+                      " [\n rankdir=LR shape=plaintext\n label=<",
+                      "<table border=\'1\'",
+                      " bgcolor=", style.bgcolor,
+                      " cellborder=\'1\'",
+                      " color=", style.color,
+                      ">",
+                      " <tr><td colspan=\'2\'>", name, "</td></tr>" );
+}
+
+void add_table_row( string &out, string_view property, string_view type, const char *cellColor, bool struck ) {
+    append_to_string( out, "\n<tr><td PORT=\"", property, "\" ALIGN=\"LEFT\"" );
+    if ( cellColor != nullptr ) {
+        append_to_string( out, " BGCOLOR=\"", cellColor, "\"" );
+    }
+    append_to_string( out, ">", struck ? "<S>" : "", property, struck ? "</S>" : "", "</td><td ALIGN=\"LEFT\"" );
+    if ( cellColor != nullptr ) {
+        append_to_string( out, " BGCOLOR=\"", cellColor, "\"" );
+    }
+    append_to_string( out, ">", struck ? "<S>" : "", type, struck ? "</S>" : "", "</td></tr>" );
+}
+
+void close_table( string &out, const TableStyle &style ) {
+    append_to_string( out, " </table>\n>]", " [fillcolor=", style.fill, " style=", style.style, " fontname=Helvetica];\n" );
+}
+
+void Graph::render_table( uint32_t entity, string &out ) const {
+    static const TableStyle style;
+
+    open_table( out, edm.strings[edm.entityNames[entity]], style );
+    auto properties = edm.properties( entity );
+    for ( uint32_t i = properties.begin; i < properties.end; ++i ) {
+        add_table_row( out, edm.strings[edm.propertyNames[i]], edm.strings[edm.propertyTypes[i]] );
+    }
+    close_table( out, style );
+}
+
+void Graph::render_arrow( uint32_t edge, string &out ) const {
+    if ( !stubs.empty() ) {
+
+        // A stub has no ports --
+
+        bool sourceStub = stubbed.test( index.source( edge ) );
+        bool targetStub = stubbed.test( index.target( edge ) );
+        append_to_string( out, edm.strings[edm.edge_source_name( edge )], sourceStub ? "" : ":", sourceStub ? "" : edm.strings[edm.edgeSourceFields[edge]],
+                          " -> ", edm.strings[edm.edgeTargets[edge]], targetStub ? "" : ":", targetStub ? "" : edm.strings[edm.edgeTargetFields[edge]] );
+        return;
+    }
+    append_to_string( out, edm.strings[edm.edge_source_name( edge )], ":", edm.strings[edm.edgeSourceFields[edge]], " -> ",
+                      edm.strings[edm.edgeTargets[edge]], ":", edm.strings[edm.edgeTargetFields[edge]] );
+}
+
+/**
+ * Arrows are ordered by source name and field; edges of the same field keep
+ * document order.
+ */
+bool Graph::arrow_before( uint32_t a, uint32_t b ) const {
+    int order = edm.edge_source_name( a ) == edm.edge_source_name( b )
+                    ? edm.strings[edm.edgeSourceFields[a]].compare( edm.strings[edm.edgeSourceFields[b]] )
+                    : compare_joined( edm.strings[edm.edge_source_name( a )], edm.strings[edm.edgeSourceFields[a]],
+                                      edm.strings[edm.edge_source_name( b )], edm.strings[edm.edgeSourceFields[b]] );
+    return order < 0 || ( order == 0 && a < b );
+}
+
+/**
+ * True if edge resolved, so it can be drawn; reports it otherwise.
+ */
+bool Graph::drawable( uint32_t edge ) const {
+    if ( edm.edgeTargetRows[edge] != EDMModel::NoEntity ) {
+        return true;
+    }
+    cout << "[ERROR]: unresolved navigation type => " << edm.strings[edm.edgeTargetTypes[edge]] << " on "
+         << edm.strings[edm.edge_source_name( edge )] << ":" << edm.strings[edm.edgeSourceFields[edge]] << " skipping.." << endl;
+    return false;
+}
+
+void Graph::create_arrows() {
+    if ( !filtered && replaced.revision == modelRevision && arrowsRevision != NoRevision && arrowsRevision + 1 == modelRevision ) {
+        update_arrows();
+        arrowsRevision = modelRevision;
+        return;
+    }
+
+    vector<uint32_t> order;
+    if ( filtered ) {
+        order = edges;
+    } else {
+        order.resize( edm.edge_count() );
+        iota( order.begin(), order.end(), 0 );
+    }
+    sort( order.begin(), order.end(), [&]( uint32_t a, uint32_t b ) { return arrow_before( a, b ); } );
+
+    arrows.clear();
+    copy_if( order.begin(), order.end(), back_inserter( arrows ), [&]( uint32_t edge ) { return drawable( edge ); } );
+    arrowsRevision = filtered ? NoRevision : modelRevision;
+}
+
+/**
+ * create_arrows() after a replace(). Kept arrows whose source and target
+ * did not change keep their order, so only the new edges and the changed
+ * ones are sorted, and merged in.
+ */
+void Graph::update_arrows() {
+    const auto &at = replaced.at;
+    const auto &removed = replaced.removed;
+    const auto &added = replaced.added;
+    const auto &changes = replaced.changes;
+
+    vector<bool> renamed( edm.entity_count(), false );
+    for ( uint32_t row : changes.renamed ) {
+        renamed[row] = true;
+    }
+    vector<bool> retargeted( edm.edge_count(), false );
+    for ( uint32_t edge : changes.retargeted ) {
+        retargeted[edge] = true;
+    }
+    auto changed = [&]( uint32_t edge ) { return retargeted[edge] || renamed[edm.edgeSources[edge]]; };
+
+    vector<uint32_t> kept;
+    kept.reserve( arrows.size() );
+    for ( uint32_t before : arrows ) {
+        uint32_t edge = EDMModel::row_after( before, at.edges, removed.edges, added.edges );
+        if ( edge != EDMModel::NoEntity && !changed( edge ) ) {
+            kept.push_back( edge );
+        }
+    }
+
+    vector<uint32_t> order( added.edges );
+    iota( order.begin(), order.end(), at.edges );
+    if ( changes.renamed.empty() ) {
+        order.insert( order.end(), changes.retargeted.begin(), changes.retargeted.end() );
+    } else {
+        for ( uint32_t edge = 0; edge < edm.edge_count(); ++edge ) {
+            if ( ( edge < at.edges || edge >= at.edges + added.edges ) && changed( edge ) ) {
+                order.push_back( edge );
+            }
+        }
+    }
+    sort( order.begin(), order.end(), [&]( uint32_t a, uint32_t b ) { return arrow_before( a, b ); } );
+    order.erase( remove_if( order.begin(), order.end(), [&]( uint32_t edge ) { return !drawable( edge ); } ), order.end() );
+
+    arrows.clear();
+    std::merge( kept.begin(), kept.end(), order.begin(), order.end(), back_inserter( arrows ),
+                [&]( uint32_t a, uint32_t b ) { return arrow_before( a, b ); } );
+}
+
+Adjacency::Bits Graph::arrow_bits() {
+    Adjacency::Bits bits( edm.edge_count() );
+    for ( uint32_t edge : arrows ) {
+        bits.set( edge );
+    }
+    return bits;
+}
+
+void Graph::table_rows( vector<uint32_t> &rows ) const {
+    if ( filtered ) {
+        rows = tables;
+    } else {
+        rows.resize( edm.entity_count() );
+        iota( rows.begin(), rows.end(), 0 );
+    }
+}
+
+void Graph::create_clusters( Components::Kind kind ) {
+    const auto &graph = adjacency();
+    Components components;
+    components.compute( graph, arrow_bits(), kind );
+
+    vector<uint32_t> rows;
+    table_rows( rows );
+    auto component_of = [&]( uint32_t entity ) { return components.of( graph.node( edm.entityNames[entity] ) ); };
+
+    // Clusters are the components with more than one table, numbered by their first table --
+
+    vector<uint32_t> entities( components.count(), 0 );
+    for ( uint32_t entity : rows ) {
+        ++entities[component_of( entity )];
+    }
+    vector<uint32_t> cluster( components.count(), NoCluster );
+    uint32_t clusters = 0;
+    for ( uint32_t entity : rows ) {
+        auto component = component_of( entity );
+        if ( entities[component] > 1 && cluster[component] == NoCluster ) {
+            cluster[component] = clusters++;
+        }
+    }
+
+    // Each cluster in document order, then the tables outside any --
+
+    stable_sort( rows.begin(), rows.end(), [&]( uint32_t a, uint32_t b ) { return cluster[component_of( a )] < cluster[component_of( b )]; } );
+    tables = move( rows );
+    filtered = true;
+    tableClusters.resize( tables.size() );
+    for ( size_t i = 0; i < tables.size(); ++i ) {
+        tableClusters[i] = cluster[component_of( tables[i] )];
+    }
+}
+
+size_t Graph::print_components( const function<string( size_t )> &fileName, unsigned threads ) {
+    Components components;
+    components.compute( adjacency(), arrow_bits(), Components::Kind::Weak );
+
+    auto parts = print_groups( [&]( Adjacency::Node node ) { return components.of( node ); }, components.count(), fileName, threads );
+    return static_cast<size_t>( count_if( parts.begin(), parts.end(), []( const Part &part ) { return part.tables > 0; } ) );
+}
+
+vector<Graph::Part> Graph::print_communities( uint32_t maxSize, const function<string( size_t )> &fileName, unsigned threads ) {
+    Communities communities;
+    communities.compute( adjacency(), arrow_bits(), maxSize, threads );
+    return print_groups( [&]( Adjacency::Node node ) { return communities.of( node ); }, communities.count(), fileName, threads );
+}
+
+/**
+ * Writes each group of adjacency nodes as a part of its own. Part 0 takes
+ * the groups without arrows, the others a group each in order of their
+ * first table.
+ */
+vector<Graph::Part> Graph::print_groups( const function<uint32_t( Adjacency::Node )> &groupOf, uint32_t groups,
+                                         const function<string( size_t )> &fileName, unsigned threads ) {
+    const auto &graph = adjacency();
+    vector<uint32_t> rows;
+    table_rows( rows );
+
+    vector<bool> connected( groups, false );
+    for ( uint32_t edge : arrows ) {
+        connected[groupOf( graph.source( edge ) )] = true;
+        connected[groupOf( graph.target( edge ) )] = true;
+    }
+    vector<uint32_t> partOfGroup( groups, NoCluster );
+    vector<Part> parts( 1 );
+    auto part_of = [&]( Adjacency::Node node ) {
+        auto group = groupOf( node );
+        if ( partOfGroup[group] == NoCluster ) {
+            partOfGroup[group] = connected[group] ? static_cast<uint32_t>( parts.size() ) : 0;
+            if ( partOfGroup[group] != 0 ) {
+                parts.emplace_back();
+            }
+        }
+        return partOfGroup[group];
+    };
+
+    // Tables, arrows and stubs of every part; an arrow between parts goes to both --
+
+    vector<vector<uint32_t>> partTables( 1 );
+    vector<vector<uint32_t>> partArrows( 1 );
+    vector<vector<Adjacency::Node>> partStubs( 1 );
+    auto grow = [&]() {
+        partTables.resize( parts.size() );
+        partArrows.resize( parts.size() );
+        partStubs.resize( parts.size() );
+    };
+    for ( uint32_t entity : rows ) {
+        auto part = part_of( graph.node( edm.entityNames[entity] ) );
+        grow();
+        partTables[part].push_back( entity );
+    }
+    for ( uint32_t edge : arrows ) {
+        auto source = graph.source( edge );
+        auto target = graph.target( edge );
+        auto from = part_of( source );
+        auto to = part_of( target );
+        grow();
+        partArrows[from].push_back( edge );
+        if ( from != to ) {
+            partArrows[to].push_back( edge );
+            partStubs[from].push_back( target );
+            partStubs[to].push_back( source );
+            auto &links = parts[from].links;
+            auto link = find_if( links.begin(), links.end(), [&]( const pair<uint32_t, size_t> &l ) { return l.first == to; } );
+            if ( link == links.end() ) {
+                links.emplace_back( to, 1 );
+            } else {
+                ++link->second;
+            }
+        }
+    }
+
+    // Print each as if it were the whole graph --
+
+    auto saved = make_tuple( move( tables ), move( arrows ), move( tableClusters ), filtered );
+    stubbed = Adjacency::Bits( graph.node_count() );
+    bool ok = true;
+    for ( size_t i = 0; i < parts.size() && ok; ++i ) {
+        auto &part = parts[i];
+        part.fileName = fileName( i );
+        if ( partTables[i].empty() ) {
+            continue;
+        }
+        sort( partStubs[i].begin(), partStubs[i].end() );
+        partStubs[i].erase( unique( partStubs[i].begin(), partStubs[i].end() ), partStubs[i].end() );
+
+        tables = move( partTables[i] );
+        arrows = move( partArrows[i] );
+        stubs = move( partStubs[i] );
+        tableClusters.clear();
+        filtered = true;
+        stubFiles.clear();
+        for ( auto stub : stubs ) {
+            stubbed.set( stub );
+            auto name = fileName( part_of( stub ) );
+            stubFiles.push_back( name.substr( name.find_last_of( "/\\" ) + 1 ) );
+        }
+        part.tables = tables.size();
+        part.arrows = arrows.size();
+        part.stubs = stubs.size();
+        sort( part.links.begin(), part.links.end() );
+
+        ofstream stream( part.fileName );
+        if ( stream.is_open() ) {
+            print_graph( stream, threads );
+        } else {
+            ok = false;
+        }
+        for ( auto stub : stubs ) {
+            stubbed.reset( stub );
+        }
+    }
+    stubs.clear();
+    stubFiles.clear();
+    stubbed = Adjacency::Bits();
+    tie( tables, arrows, tableClusters, filtered ) = move( saved );
+    if ( !ok ) {
+        parts.clear();
+    }
+    return parts;
+}
+
+void Graph::render_stub( size_t stub, string &out ) const {
+    auto name = edm.strings[index.name( stubs[stub] )];
+    append_to_string( out, name, " [shape=box style=dashed fontname=Helvetica label=\"", name, "\\n", stubFiles[stub], "\" URL=\"", stubFiles[stub],
+                      "\"];\n" );
+}
+
+/**
+ * Element i of the output: the tables first, then the stubs, then the
+ * arrows. A table that starts or ends a cluster opens or closes its
+ * subgraph.
+ */
+void Graph::render_element( size_t element, string &out ) const {
+    if ( element < table_count() ) {
+        uint32_t cluster = element < tableClusters.size() ? tableClusters[element] : NoCluster;
+        if ( cluster != NoCluster && ( element == 0 || tableClusters[element - 1] != cluster ) ) {
+            append_to_string( out, "subgraph cluster_", to_string( cluster ), " {\n style=dashed color=grey\n" );
+        }
+        render_table( filtered ? tables[element] : static_cast<uint32_t>( element ), out );
+        if ( cluster != NoCluster && ( element + 1 == tableClusters.size() || tableClusters[element + 1] != cluster ) ) {
+            out.append( "}\n" );
+        }
+    } else if ( element < table_count() + stubs.size() ) {
+        render_stub( element - table_count(), out );
+    } else {
+        render_arrow( arrows[element - table_count() - stubs.size()], out );
+    }
+    out.push_back( '\n' );
+}
+
+bool Graph::prints_whole_model() const {
+    return !filtered && stubs.empty() && tableClusters.empty() && arrowsRevision == modelRevision;
+}
+
+void Graph::print_graph( ostream &stream, unsigned threads, vector<uint64_t> *offsets ) {
+    DotWriter writer( stream );
+    auto &out = writer.buffer();
+
+    // Elements per run handed to a thread, and runs rendered between writes --
+
+    constexpr size_t RunLength = 512;
+    constexpr size_t RunsPerThread = 4;
+
+    size_t elements = table_count() + stubs.size() + arrows.size();
+    if ( offsets != nullptr ) {
+        offsets->assign( elements + 1, 0 );
+    }
+
+    out.append( GraphHeader );
+    if ( threads <= 1 || elements <= RunLength ) {
+        for ( size_t element = 0; element < elements; ++element ) {
+            if ( offsets != nullptr ) {
+                ( *offsets )[element] = writer.position();
+            }
+            render_element( element, out );
+            writer.commit();
+        }
+    } else {
+
+        // Batches of runs in two sets of buffers: the pool renders the next batch while this one is written --
+
+        ThreadPool pool( threads );
+        size_t batchRuns = pool.size() * RunsPerThread;
+        size_t batchLength = batchRuns * RunLength;
+        vector<string> buffers[2] = {vector<string>( batchRuns ), vector<string>( batchRuns )};
+        auto runs_in = [&]( size_t first ) { return ( min( elements, first + batchLength ) - first + RunLength - 1 ) / RunLength; };
+
+        size_t rendering = 0; // First element of the batch on the pool
+        vector<string> *into = nullptr;
+        auto render = [&]( size_t run ) {
+            auto &buffer = ( *into )[run];
+            buffer.clear();
+            for ( size_t element = rendering + run * RunLength, end = min( elements, element + RunLength ); element < end; ++element ) {
+                if ( offsets != nullptr ) {
+                    ( *offsets )[element] = buffer.size();
+                }
+                render_element( element, buffer );
+            }
+        };
+
+        into = &buffers[0];
+        pool.parallel_for( runs_in( 0 ), render );
+        for ( size_t first = 0, batch = 0; first < elements; first += batchLength, ++batch ) {
+            bool next = first + batchLength < elements;
+            if ( next ) {
+                rendering = first + batchLength;
+                into = &buffers[( batch + 1 ) % 2];
+                pool.start( runs_in( rendering ), render );
+            }
+            auto &runs = buffers[batch % 2];
+            for ( size_t run = 0, count = runs_in( first ); run < count; ++run ) {
+                if ( offsets != nullptr ) {
+                    uint64_t base = writer.position();
+                    for ( size_t element = first + run * RunLength, end = min( elements, element + RunLength ); element < end; ++element ) {
+                        ( *offsets )[element] += base;
+                    }
+                }
+                writer.append( runs[run] );
+            }
+            if ( next ) {
+                pool.wait();
+            }
+        }
+    }
+    if ( offsets != nullptr ) {
+        offsets->back() = writer.position();
+    }
+    out.append( GraphFooter );
+
+    writer.finish();
+}
+
+namespace {
+
+/**
+ * The attributes of an element indexed by their EDMName, collected in one
+ * pass over the attribute list. Missing attributes read as "".
+ */
+struct AttributeSlots {
+    explicit AttributeSlots( const XMLElement *element ) {
+        for ( const XMLAttribute *attribute = element->FirstAttribute(); attribute != nullptr; attribute = attribute->Next() ) {
+            values[attribute->NameId()] = attribute->Value();
+        }
+    }
+
+    const char *operator[]( EDMName name ) const {
+        auto value = values[static_cast<size_t>( name )];
+        return value != nullptr ? value : "";
+    }
+
+  private:
+    const char *values[static_cast<size_t>( EDMName::Count )] = {};
+};
+
+} // namespace
+
+void Graph::find_all_properties( const XMLElement *element ) {
+    for ( const XMLElement *child = element->FirstChildElement(); child != nullptr; child = child->NextSiblingElement() ) {
+
+        switch ( edm_name( child->NameId() ) ) {
+        case EDMName::Property: {
+            AttributeSlots attributes{child};
+            add_property( attributes[EDMName::Name], attributes[EDMName::Type] );
+            break;
+        }
+
+        case EDMName::NavigationProperty: {
+            string_view type = AttributeSlots{child}[EDMName::Type];
+            for ( const XMLElement *innerchild = child->FirstChildElement(); innerchild != nullptr; innerchild = innerchild->NextSiblingElement() ) {
+                if ( edm_name( innerchild->NameId() ) == EDMName::ReferentialConstraint ) {
+                    AttributeSlots attributes{innerchild};
+                    add_referential_constraint( type, attributes[EDMName::Property], attributes[EDMName::ReferencedProperty] );
+                }
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+}
+
+void Graph::visit( const XMLNode *root ) {
+    for ( const XMLElement *child = root->FirstChildElement(); child != nullptr; child = child->NextSiblingElement() ) {
+
+        switch ( edm_name( child->NameId() ) ) {
+        case EDMName::Schema: {
+            AttributeSlots attributes{child};
+            begin_schema( attributes[EDMName::Namespace], attributes[EDMName::Alias] );
+            break;
+        }
+
+        case EDMName::EntityType:
+            begin_entity_type( AttributeSlots{child}[EDMName::Name] );
+            find_all_properties( child );
+            end_entity_type();
+            break;
+
+        case EDMName::EntitySet: {
+            AttributeSlots attributes{child};
+            add_entity( attributes[EDMName::Name], attributes[EDMName::EntityType] );
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        visit( child );
+    }
+}
+
+void Graph::borrow_from( shared_ptr<const XMLDocument> document ) {
+    const char *text = document->CharBuffer();
+    size_t length = document->CharBufferLength();
+    edm.strings.borrow( text, length, move( document ) );
+}
+
+void Graph::merge( Graph &&other ) {
+    edm.append( other.edm );
+    indexed = false;
+    resolved = false;
+    ++modelRevision;
+    other.edm = EDMModel{};
+}
+
+void Graph::merge( const Graph &other ) {
+    edm.append( other.edm );
+    indexed = false;
+    resolved = false;
+    ++modelRevision;
+}
+
+const Adjacency &Graph::adjacency() {
+    if ( !indexed ) {
+        index.build( edm );
+        indexed = true;
+    }
+    return index;
+}
+
+void Graph::removeAllEntitiesNotRelatedTo( string centerEntity, unsigned depth, Adjacency::Direction direction ) {
+    const auto &graph = adjacency();
+    auto center = graph.node( edm.strings.find( centerEntity ) );
+
+    Adjacency::Bits centers( graph.node_count() );
+    if ( center != Adjacency::None ) {
+        centers.set( center );
+    }
+    keep_neighborhood( centers, depth, direction );
+}
+
+void Graph::removeAllEntitiesNotRelatedTo( const vector<EntityPattern> &centers, unsigned depth, Adjacency::Direction direction ) {
+    const auto &graph = adjacency();
+    Adjacency::Bits nodes( graph.node_count() );
+
+    bool patterns = false;
+    for ( const auto &center : centers ) {
+        if ( center.kind() == EntityPattern::Kind::Name ) {
+            auto node = graph.node( edm.strings.find( center.text() ) );
+            if ( node != Adjacency::None ) {
+                nodes.set( node );
+            }
+        } else {
+            patterns = true;
+        }
+    }
+
+    // Nodes are distinct names, so each name is tried once; only entities can match --
+
+    if ( patterns ) {
+        for ( Adjacency::Node node = 0; node < graph.node_count(); ++node ) {
+            if ( nodes.test( node ) || graph.entities( node ).size() == 0 ) {
+                continue;
+            }
+            auto name = edm.strings[graph.name( node )];
+            for ( const auto &center : centers ) {
+                if ( center.kind() != EntityPattern::Kind::Name && center.matches( name ) ) {
+                    nodes.set( node );
+                    break;
+                }
+            }
+        }
+    }
+    keep_neighborhood( nodes, depth, direction );
+}
+
+/**
+ * A breadth first search over the adjacency index from all centers at
+ * once, see Adjacency::neighborhood(). Only the adjacency lists of the
+ * entities closer than depth are visited.
+ */
+void Graph::keep_neighborhood( Adjacency::Bits &centers, unsigned depth, Adjacency::Direction direction ) {
+    Adjacency::Bits relatedEdges( edm.edge_count() );
+    adjacency().neighborhood( centers, relatedEdges, depth, direction );
+    keep( centers, relatedEdges );
+}
+
+void Graph::keep( const Adjacency::Bits &nodes, const Adjacency::Bits &keptEdges ) {
+    const auto &graph = adjacency();
+
+    edges.clear();
+    tables.clear();
+    tableClusters.clear();
+    filtered = true;
+
+    keptEdges.for_each( [&]( uint32_t edge ) { edges.push_back( edge ); } );
+    nodes.for_each( [&]( Adjacency::Node node ) {
+        for ( uint32_t entity : graph.entities( node ) ) {
+            tables.push_back( entity );
+        }
+    } );
+    sort( tables.begin(), tables.end() );
+}
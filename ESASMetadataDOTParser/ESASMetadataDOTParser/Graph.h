@@ -0,0 +1,277 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef Graph_h
+#define Graph_h
+
+#include "Adjacency.h"
+#include "Communities.h"
+#include "Components.h"
+#include "EDMModel.h"
+#include "EntityPattern.h"
+#include "tinyxml2.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Helpers
+ */
+
+template <typename... Args>
+void append_to_string( std::string &str, Args... args ) {
+    ( str.append( args ), ... );
+}
+
+/**
+ * How an entity table is drawn. The defaults are the plain diagram; --diff
+ * colours added, removed and changed entities.
+ */
+struct TableStyle {
+    const char *color = "\'aliceblue\'";
+    const char *bgcolor = "\'lightskyblue\'";
+    const char *fill = "aliceblue";
+    const char *style = "filled";
+};
+
+void open_table( std::string &out, std::string_view name, const TableStyle &style );
+void add_table_row( std::string &out, std::string_view property, std::string_view type, const char *cellColor = nullptr, bool struck = false );
+void close_table( std::string &out, const TableStyle &style );
+
+struct Graph {
+
+    /**
+     * Extraction events, fed either by the DOM walk in visit() or by the
+     * streaming CSDLReader. An EntityType is collected between
+     * begin_entity_type() and end_entity_type() and then turned into a table.
+     */
+    void begin_schema( std::string_view schemaNamespace, std::string_view alias );
+    void begin_entity_type( std::string_view name );
+    void add_property( std::string_view name, std::string_view type );
+    void add_referential_constraint( std::string_view type, std::string_view property, std::string_view referencedProperty );
+    void end_entity_type();
+
+    void add_entity( std::string_view name, std::string_view type );
+
+    /**
+     * Runs once everything is read: resolves navigation types and names
+     * entities after their EntitySet, see EDMModel::resolve(). Arrows whose
+     * type stays unresolved are reported and left out by create_arrows().
+     * Does nothing if nothing was read since the last time.
+     */
+    void resolve();
+
+    /**
+     * Replaces the model with one that has already been resolved, as loaded
+     * by ModelSnapshot, so resolve() leaves it as it is.
+     */
+    void assign( EDMModel &&model );
+
+    /**
+     * Replaces count rows of the model from rows at by the model of other,
+     * for --watch, and drops any filter. A resolved model stays resolved,
+     * see EDMModel::replace(). The next create_arrows() moves only the
+     * arrows of the new rows and of the rows that changed.
+     */
+    void replace( const EDMModel::Rows &at, const EDMModel::Rows &count, Graph &&other );
+
+    /**
+     * What the last replace() did, and the revision() it made. If that is
+     * the revision now, it is the only change since the revision before.
+     */
+    struct Replacement {
+        uint64_t revision = 0;
+        EDMModel::Rows at;
+        EDMModel::Rows removed;
+        EDMModel::Rows added;
+        EDMModel::Changes changes;
+    };
+    const Replacement &replacement() const { return replaced; }
+
+    /**
+     * Moves on with every change to the model: reading, merging, resolving,
+     * assign() and replace(). Filters leave it as it is.
+     */
+    uint64_t revision() const { return modelRevision; }
+
+    void create_arrows();
+
+    /**
+     * Groups the tables by the strong or weak components of the arrows, so
+     * print_graph() writes every component of more than one entity as a
+     * subgraph cluster_<n>. Call after create_arrows().
+     */
+    void create_clusters( Components::Kind kind );
+
+    /**
+     * Writes every weak component of the arrows to a DOT file of its own,
+     * named by fileName( n ) for n = 1.., and the entities without arrows
+     * together to fileName( 0 ). Call after create_arrows(). Returns the
+     * number of files written, or 0 if one could not be written.
+     */
+    size_t print_components( const std::function<std::string( size_t )> &fileName, unsigned threads = 1 );
+
+    /**
+     * A file written by print_communities().
+     */
+    struct Part {
+        std::string fileName;
+        size_t tables = 0;
+        size_t arrows = 0; // Including those to and from stubs
+        size_t stubs = 0;
+        std::vector<std::pair<uint32_t, size_t>> links; // Arrows to other parts by part number
+    };
+
+    /**
+     * Splits the arrows into Communities of at most maxSize entities and
+     * writes each to fileName( n ) for n = 1.., the entities without arrows
+     * to fileName( 0 ). Arrows between communities are written to both
+     * files, to a stub node for the entity in the other file. Returns the
+     * parts by number, empty if a file could not be written.
+     */
+    std::vector<Part> print_communities( uint32_t maxSize, const std::function<std::string( size_t )> &fileName, unsigned threads = 1 );
+
+    /**
+     * Writes the tables and arrows as DOT. With more than one thread, runs
+     * of elements are rendered on a ThreadPool into separate buffers and
+     * written in order, so the output is the same as with one thread. The
+     * pool renders the next batch of runs while one is written. If offsets
+     * is given, notes where every element starts in it, with one more entry
+     * where the last one ends.
+     */
+    void print_graph( std::ostream &stream, unsigned threads = 1, std::vector<uint64_t> *offsets = nullptr );
+
+    /**
+     * Appends element i of print_graph() to out. The elements are written
+     * between GraphHeader and GraphFooter.
+     */
+    void render_element( size_t element, std::string &out ) const;
+    static constexpr std::string_view GraphHeader = "digraph Data {\n";
+    static constexpr std::string_view GraphFooter = "}\n";
+
+    /**
+     * True if print_graph() writes every table of the model in row order and
+     * the arrows of all of it as create_arrows() left them for revision(),
+     * with no filter, clusters or stubs.
+     */
+    bool prints_whole_model() const;
+
+    /**
+     * DOM walk. Dispatches on XMLElement::NameId(), so the document must be
+     * parsed with SetNameClassifier( classify_edm_name ).
+     */
+    void find_all_properties( const tinyxml2::XMLElement *element );
+    void visit( const tinyxml2::XMLNode *root );
+
+    /**
+     * Lets the model refer to names in the text of document instead of
+     * copying them, see StringTable::borrow(). The graph keeps document
+     * alive from then on. Call after the document is loaded.
+     */
+    void borrow_from( std::shared_ptr<const tinyxml2::XMLDocument> document );
+
+    /**
+     * Appends everything another graph has extracted, as if its input had
+     * followed ours in the document. Used to combine per-thread results.
+     */
+    void merge( Graph &&other );
+    void merge( const Graph &other );
+
+    /**
+     * Keeps the center entity and the entities up to depth navigation edges
+     * away from it along direction, with the edges that lead to them.
+     */
+    void removeAllEntitiesNotRelatedTo( std::string centerEntity, unsigned depth = 1,
+                                        Adjacency::Direction direction = Adjacency::Direction::Both );
+
+    /**
+     * The same around every entity that matches one of centers, in a single
+     * search from all of them. Patterns are matched once per distinct name.
+     */
+    void removeAllEntitiesNotRelatedTo( const std::vector<EntityPattern> &centers, unsigned depth = 1,
+                                        Adjacency::Direction direction = Adjacency::Direction::Both );
+
+    /**
+     * Keeps the entities of the adjacency nodes set in nodes and the edges
+     * set in edges, as found by a search over adjacency().
+     */
+    void keep( const Adjacency::Bits &nodes, const Adjacency::Bits &edges );
+
+    const EDMModel &model() const { return edm; }
+    size_t table_count() const { return filtered ? tables.size() : edm.entity_count(); }
+    size_t arrow_count() const { return arrows.size(); }
+    const std::vector<uint32_t> &arrow_edges() const { return arrows; } // In output order
+
+    /**
+     * Navigation index over the model, built on first use. Invalidated by
+     * anything that adds to the model.
+     */
+    const Adjacency &adjacency();
+
+  private:
+    EDMModel edm;
+    EDMModel::Id currentNamespace = StringTable::None;
+    uint32_t currentEntity = 0;
+    bool resolved = false;
+    uint64_t modelRevision = 0;
+    Replacement replaced;
+
+    Adjacency index;
+    bool indexed = false;
+
+    // What gets printed; all entities unless a filter has picked some --
+    bool filtered = false;
+    std::vector<uint32_t> tables;
+    std::vector<uint32_t> edges;
+    std::vector<uint32_t> arrows;        // Edges in output order, set by create_arrows()
+    uint64_t arrowsRevision = NoRevision; // Revision the arrows are of the whole model of
+    static constexpr uint64_t NoRevision = UINT64_MAX;
+    std::vector<uint32_t> tableClusters; // Cluster of every table, NoCluster outside one; empty without create_clusters()
+    static constexpr uint32_t NoCluster = UINT32_MAX;
+
+    // Stub nodes standing for entities printed elsewhere, and the files they are in --
+    std::vector<Adjacency::Node> stubs;
+    std::vector<std::string> stubFiles;
+    Adjacency::Bits stubbed;
+
+    bool arrow_before( uint32_t a, uint32_t b ) const;
+    bool drawable( uint32_t edge ) const;
+    void update_arrows();
+
+    Adjacency::Bits arrow_bits();
+    void table_rows( std::vector<uint32_t> &rows ) const;
+    std::vector<Part> print_groups( const std::function<uint32_t( Adjacency::Node )> &groupOf, uint32_t groups,
+                                    const std::function<std::string( size_t )> &fileName, unsigned threads );
+    void render_stub( size_t stub, std::string &out ) const;
+
+    void keep_neighborhood( Adjacency::Bits &centers, unsigned depth, Adjacency::Direction direction );
+    void render_table( uint32_t entity, std::string &out ) const;
+    void render_arrow( uint32_t edge, std::string &out ) const;
+};
+
+#endif /* Graph_h */
@@ -0,0 +1,238 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+
+#include "IncrementalReader.h"
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t ChunkSize = 64 * 1024; // Average, the unit of re-parsing
+constexpr size_t BatchPerThread = 4;    // Chunks parsed per thread before they are merged
+
+} // namespace
+
+IncrementalReader::IncrementalReader( Graph &graph, unsigned threads ) : graph( graph ), threadCount( max( 1u, threads ) ) {
+}
+
+bool IncrementalReader::read( const char *fileName ) {
+    MappedFile file;
+    if ( !file.open( fileName ) ) {
+        errorText = "Couldn't open input file " + string{fileName};
+        return false;
+    }
+    totalRead = file.size();
+
+    auto xml = string_view{file.data(), file.size()};
+    bool ok = true;
+    if ( pieces.empty() || !update( xml, ok ) ) {
+        ok = read_all( xml );
+    }
+    return ok;
+}
+
+bool IncrementalReader::read_all( string_view xml ) {
+    vector<ParallelReader::Range> entityChunks;
+    vector<ParallelReader::Range> containers;
+    ParallelReader::Span span{0, xml.size(), {}};
+    ParallelReader::scan( xml, ChunkSize, entityChunks, containers, true );
+
+    vector<ParallelReader::Range> ranges;
+    auto found = make_pieces( xml, span, entityChunks, containers, ranges );
+    Graph model;
+    if ( !parse( xml, ranges, found.data(), model ) ) {
+        return false;
+    }
+    graph = move( model );
+    pieces = move( found );
+    chunks = parsed = ranges.size();
+    modelChanged = true;
+    return true;
+}
+
+/**
+ * Returns false if the file has to be read in full. Sets ok to false if the
+ * changed bytes do not parse; the graph is left as it was then.
+ */
+bool IncrementalReader::update( string_view xml, bool &ok ) {
+    size_t count = pieces.size();
+    size_t oldSize = pieces.back().end;
+    ptrdiff_t shift = static_cast<ptrdiff_t>( xml.size() ) - static_cast<ptrdiff_t>( oldSize );
+    auto same = [&]( const Piece &piece, ptrdiff_t by ) {
+        size_t begin = piece.begin + by;
+        size_t end = piece.end + by;
+        return end <= xml.size() && content_hash( xml.data() + begin, end - begin ) == piece.hash;
+    };
+
+    // Unchanged pieces at the front, the last of which must still end the file, and at the back --
+
+    size_t first = 0;
+    while ( first < count && ( first + 1 < count || shift == 0 ) && same( pieces[first], 0 ) ) {
+        ++first;
+    }
+    if ( first == count ) {
+        parsed = 0;
+        modelChanged = false;
+        return true;
+    }
+    size_t last = count;
+    while ( last > first && static_cast<ptrdiff_t>( pieces[last - 1].begin ) + shift >= static_cast<ptrdiff_t>( pieces[first].begin ) &&
+            same( pieces[last - 1], shift ) ) {
+        --last;
+    }
+
+    // Scan the bytes between in the Schema the first changed piece began in, which must end in the one the next piece began in --
+
+    size_t begin = pieces[first].begin;
+    size_t oldEnd = last < count ? pieces[last].begin : oldSize;
+    ParallelReader::Span span{begin, oldEnd + shift, {}};
+    if ( pieces[first].schemaTag != string_view::npos ) {
+        span.schemaTag = xml.substr( pieces[first].schemaTag, pieces[first].schemaTagLength );
+    }
+    auto stretch = span;
+    vector<ParallelReader::Range> entityChunks;
+    vector<ParallelReader::Range> containers;
+    ParallelReader::scan( xml, ChunkSize, entityChunks, containers, true, &span );
+    uint64_t schemaKey = span.schemaTag.empty() ? 0 : content_hash( span.schemaTag.data(), span.schemaTag.size() );
+    if ( span.end != stretch.end || ( last < count && schemaKey != pieces[last].schemaKey ) ) {
+        return false;
+    }
+
+    vector<ParallelReader::Range> ranges;
+    auto found = make_pieces( xml, stretch, entityChunks, containers, ranges );
+    Graph replacement;
+    if ( !parse( xml, ranges, found.data(), replacement ) ) {
+        ok = false;
+        return true;
+    }
+
+    // Swap the rows in --
+
+    EDMModel::Rows at;
+    EDMModel::Rows replaced;
+    for ( size_t i = 0; i < last; ++i ) {
+        ( i < first ? at : replaced ) += pieces[i].rows;
+    }
+    modelChanged = !ranges.empty() || replaced.schemas > 0 || replaced.entities > 0 || replaced.entitySets > 0;
+    if ( modelChanged ) {
+        graph.replace( at, replaced, move( replacement ) );
+    }
+
+    // The pieces after move; those in a Schema opened in the changed bytes refer to its tag there --
+
+    for ( size_t i = last; i < count; ++i ) {
+        auto &piece = pieces[i];
+        piece.begin += shift;
+        piece.end += shift;
+        if ( piece.schemaTag != string_view::npos && piece.schemaTag >= oldEnd ) {
+            piece.schemaTag += shift;
+        } else if ( piece.schemaTag != string_view::npos && piece.schemaTag >= begin ) {
+            piece.schemaTag = static_cast<size_t>( span.schemaTag.data() - xml.data() );
+            piece.schemaTagLength = span.schemaTag.size();
+        }
+    }
+    pieces.erase( pieces.begin() + static_cast<ptrdiff_t>( first ), pieces.begin() + static_cast<ptrdiff_t>( last ) );
+    pieces.insert( pieces.begin() + static_cast<ptrdiff_t>( first ), found.begin(), found.end() );
+    chunks = static_cast<size_t>( count_if( pieces.begin(), pieces.end(), []( const Piece &piece ) { return piece.elements; } ) );
+    parsed = ranges.size();
+    return true;
+}
+
+/**
+ * One piece per chunk and container in span, in document order, and one for
+ * the bytes after the last if there are any. Fills ranges with what to
+ * parse for each; the EntitySets need no Schema, as in ParallelReader::read().
+ */
+vector<IncrementalReader::Piece> IncrementalReader::make_pieces( string_view xml, const ParallelReader::Span &span,
+                                                                 const vector<ParallelReader::Range> &entityChunks,
+                                                                 const vector<ParallelReader::Range> &containers,
+                                                                 vector<ParallelReader::Range> &ranges ) const {
+    ranges.clear();
+    std::merge( entityChunks.begin(), entityChunks.end(), containers.begin(), containers.end(), back_inserter( ranges ),
+                []( const ParallelReader::Range &a, const ParallelReader::Range &b ) { return a.begin < b.begin; } );
+
+    vector<Piece> result;
+    auto add = [&]( size_t end, string_view schemaTag, bool elements ) {
+        Piece piece{};
+        piece.begin = result.empty() ? span.begin : result.back().end;
+        piece.end = end;
+        piece.hash = content_hash( xml.data() + piece.begin, end - piece.begin );
+        piece.schemaTag = schemaTag.empty() ? string_view::npos : static_cast<size_t>( schemaTag.data() - xml.data() );
+        piece.schemaTagLength = schemaTag.size();
+        piece.schemaKey = schemaTag.empty() ? 0 : content_hash( schemaTag.data(), schemaTag.size() );
+        piece.elements = elements;
+        result.push_back( piece );
+    };
+
+    // A piece starts in the Schema the one before ended in, which is that of its elements --
+
+    string_view schemaTag = span.schemaTag;
+    for ( const auto &range : ranges ) {
+        add( range.end, schemaTag, true );
+        schemaTag = range.schemaTag;
+    }
+    if ( ( result.empty() ? span.begin : result.back().end ) < span.end ) {
+        add( span.end, schemaTag, false );
+    }
+
+    for ( size_t i = 0, next = 0; i < ranges.size(); ++i ) {
+        if ( next < containers.size() && ranges[i].begin == containers[next].begin ) {
+            ranges[i].schemaTag = {};
+            ++next;
+        }
+    }
+    return result;
+}
+
+/**
+ * Parses ranges on the pool a batch at a time and merges the results into
+ * into in order, noting the rows each adds in its piece.
+ */
+bool IncrementalReader::parse( string_view xml, const vector<ParallelReader::Range> &ranges, Piece *found, Graph &into ) {
+    ThreadPool pool( threadCount );
+    size_t batch = pool.size() * BatchPerThread;
+    vector<Graph> results( min( batch, ranges.size() ) );
+    vector<string> errors( results.size() );
+
+    for ( size_t first = 0; first < ranges.size(); first += batch ) {
+        size_t count = min( batch, ranges.size() - first );
+        pool.parallel_for( count, [&]( size_t i ) { ParallelReader::extract( xml, ranges[first + i], results[i], errors[i] ); } );
+        for ( size_t i = 0; i < count; ++i ) {
+            if ( !errors[i].empty() ) {
+                errorText = errors[i];
+                return false;
+            }
+            found[first + i].rows = results[i].model().rows();
+            into.merge( move( results[i] ) );
+            results[i] = Graph{};
+        }
+    }
+    return true;
+}
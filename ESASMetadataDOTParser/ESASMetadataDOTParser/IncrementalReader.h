@@ -0,0 +1,93 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef IncrementalReader_h
+#define IncrementalReader_h
+
+#include "EDMModel.h"
+#include "Graph.h"
+#include "ParallelReader.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * Reader for --watch, which reads the same file again after every change.
+ *
+ * The first read cuts the EntityTypes into chunks at content defined
+ * boundaries, see ParallelReader::scan(), parses them and merges them into
+ * the graph. Every chunk and EntityContainer becomes a piece of the file,
+ * with the hash of its bytes and the rows it added to the model; nothing
+ * else of it is kept.
+ *
+ * Reading again hashes the pieces from both ends of the file until they
+ * differ, scans only the bytes between the unchanged pieces, parses the
+ * chunks found there and replaces their rows of the model, see
+ * Graph::replace(). If the edit changes which Schema the following pieces
+ * are in, or leaves markup open across them, the file is read in full.
+ */
+class IncrementalReader {
+  public:
+    explicit IncrementalReader( Graph &graph, unsigned threads = std::thread::hardware_concurrency() );
+
+    bool read( const char *fileName );
+
+    const std::string &error() const { return errorText; }
+    size_t bytesRead() const { return totalRead; }
+    size_t chunkCount() const { return chunks; }
+    size_t parsedCount() const { return parsed; } // Chunks parsed by the last read
+    bool changed() const { return modelChanged; } // Whether the last read changed the model
+
+  private:
+    struct Piece {
+        size_t begin;             // End of the piece before
+        size_t end;               // Past its elements, or the end of the bytes after the last ones
+        uint64_t hash;            // Of the bytes from begin to end
+        size_t schemaTag;         // Start tag of the Schema in effect at begin, npos if none
+        size_t schemaTagLength;
+        uint64_t schemaKey;       // Hash of that tag, 0 if none
+        bool elements;            // False for the bytes after the last chunk
+        EDMModel::Rows rows;      // Added to the model
+    };
+
+    bool read_all( std::string_view xml );
+    bool update( std::string_view xml, bool &ok );
+    std::vector<Piece> make_pieces( std::string_view xml, const ParallelReader::Span &span, const std::vector<ParallelReader::Range> &entityChunks,
+                                    const std::vector<ParallelReader::Range> &containers, std::vector<ParallelReader::Range> &ranges ) const;
+    bool parse( std::string_view xml, const std::vector<ParallelReader::Range> &ranges, Piece *found, Graph &into );
+
+    Graph &graph;
+    unsigned threadCount;
+    std::vector<Piece> pieces; // In document order, from the start to the end of the file
+    size_t totalRead = 0;
+    size_t chunks = 0;
+    size_t parsed = 0;
+    bool modelChanged = false;
+    std::string errorText;
+};
+
+#endif /* IncrementalReader_h */
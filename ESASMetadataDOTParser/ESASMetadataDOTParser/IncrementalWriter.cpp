@@ -0,0 +1,191 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#include "IncrementalWriter.h"
+#include "ContentHash.h"
+#include "DotWriter.h"
+#include "EDMModel.h"
+#include "MappedFile.h"
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+using namespace std;
+
+IncrementalWriter::IncrementalWriter( string fileName ) : fileName( move( fileName ) ) {
+}
+
+bool IncrementalWriter::write( Graph &graph, unsigned threads ) {
+    bool whole = graph.prints_whole_model();
+    string temporary = fileName + ".tmp";
+
+    // The old file, if it is as it was written and one replace() is all that changed since --
+
+    MappedFile last;
+    lastPatched = known && whole && graph.replacement().revision == graph.revision() && revision + 1 == graph.revision() &&
+                  last.open( fileName.c_str() ) && last.size() == size && content_hash( last.data(), last.size() ) == hash;
+    known = false;
+    bool written = lastPatched ? patch( graph, string_view{last.data(), last.size()}, temporary ) : print( graph, whole, threads, temporary );
+    last.close();
+    if ( !written ) {
+        return false;
+    }
+
+    if ( whole ) {
+        MappedFile output;
+        if ( !output.open( temporary.c_str() ) ) {
+            return fail( temporary, "Couldn't read " + temporary + " back" );
+        }
+        size = output.size();
+        hash = content_hash( output.data(), output.size() );
+    }
+
+    error_code error;
+    filesystem::rename( temporary, fileName, error );
+    if ( error ) {
+        return fail( temporary, "Couldn't replace " + fileName + ": " + error.message() );
+    }
+    known = whole;
+    revision = graph.revision();
+    return true;
+}
+
+bool IncrementalWriter::print( Graph &graph, bool whole, unsigned threads, const string &temporary ) {
+    vector<uint64_t> offsets;
+    ofstream stream( temporary, ios::binary | ios::trunc );
+    if ( !stream.is_open() ) {
+        return fail( temporary, "Couldn't write " + temporary );
+    }
+    graph.print_graph( stream, threads, whole ? &offsets : nullptr );
+    stream.close();
+    if ( !stream ) {
+        return fail( temporary, "Couldn't write " + temporary );
+    }
+
+    // Where everything went, for the next time --
+
+    if ( whole ) {
+        const auto &model = graph.model();
+        const auto &order = graph.arrow_edges();
+        auto span = [&]( size_t element ) { return Span{offsets[element], static_cast<uint32_t>( offsets[element + 1] - offsets[element] )}; };
+        tables.resize( model.entity_count() );
+        for ( uint32_t row = 0; row < model.entity_count(); ++row ) {
+            tables[row] = span( row );
+        }
+        arrows.assign( model.edge_count(), {0, 0} );
+        for ( size_t i = 0; i < order.size(); ++i ) {
+            arrows[order[i]] = span( model.entity_count() + i );
+        }
+    }
+    return true;
+}
+
+/**
+ * Every table and arrow whose row was kept by the replace() and that did
+ * not change is copied from where it is in last, in runs as long as they
+ * follow each other there. The rest is rendered.
+ */
+bool IncrementalWriter::patch( const Graph &graph, string_view last, const string &temporary ) {
+    const auto &model = graph.model();
+    const auto &order = graph.arrow_edges();
+    const auto &replacement = graph.replacement();
+    const auto &at = replacement.at;
+    const auto &removed = replacement.removed;
+    const auto &added = replacement.added;
+
+    vector<bool> renamed( model.entity_count(), false );
+    for ( uint32_t row : replacement.changes.renamed ) {
+        renamed[row] = true;
+    }
+    vector<bool> retargeted( model.edge_count(), false );
+    for ( uint32_t edge : replacement.changes.retargeted ) {
+        retargeted[edge] = true;
+    }
+
+    // Where element i was written, length 0 if it has to be rendered, and where it goes now --
+
+    size_t tableCount = model.entity_count();
+    vector<Span> nowTables( tableCount );
+    vector<Span> nowArrows( model.edge_count(), {0, 0} );
+    auto before = [&]( size_t element ) -> Span {
+        if ( element < tableCount ) {
+            uint32_t row = EDMModel::row_before( static_cast<uint32_t>( element ), at.entities, removed.entities, added.entities );
+            return row != EDMModel::NoEntity && !renamed[element] ? tables[row] : Span{};
+        }
+        uint32_t edge = order[element - tableCount];
+        uint32_t row = EDMModel::row_before( edge, at.edges, removed.edges, added.edges );
+        return row != EDMModel::NoEntity && !retargeted[edge] && !renamed[model.edgeSources[edge]] ? arrows[row] : Span{};
+    };
+    auto now = [&]( size_t element ) -> Span & { return element < tableCount ? nowTables[element] : nowArrows[order[element - tableCount]]; };
+
+    ofstream stream( temporary, ios::binary | ios::trunc );
+    if ( !stream.is_open() ) {
+        return fail( temporary, "Couldn't write " + temporary );
+    }
+    DotWriter writer( stream );
+    auto &out = writer.buffer();
+    uint64_t runBegin = 0;
+    uint64_t runEnd = 0;
+    auto flush = [&]() {
+        writer.append( last.substr( runBegin, runEnd - runBegin ) );
+        runBegin = runEnd = 0;
+    };
+
+    out.append( Graph::GraphHeader );
+    for ( size_t element = 0, elements = tableCount + order.size(); element < elements; ++element ) {
+        auto was = before( element );
+        if ( was.second > 0 ) {
+            if ( was.first != runEnd ) {
+                flush();
+                runBegin = runEnd = was.first;
+            }
+            now( element ) = {writer.position() + ( runEnd - runBegin ), was.second};
+            runEnd += was.second;
+        } else {
+            flush();
+            uint64_t begin = writer.position();
+            graph.render_element( element, out );
+            now( element ) = {begin, static_cast<uint32_t>( writer.position() - begin )};
+            writer.commit();
+        }
+    }
+    flush();
+    out.append( Graph::GraphFooter );
+    writer.finish();
+    stream.close();
+    if ( !stream ) {
+        return fail( temporary, "Couldn't write " + temporary );
+    }
+
+    tables = move( nowTables );
+    arrows = move( nowArrows );
+    return true;
+}
+
+bool IncrementalWriter::fail( const string &temporary, const string &text ) {
+    error_code error;
+    filesystem::remove( temporary, error );
+    errorText = text;
+    known = false;
+    return false;
+}
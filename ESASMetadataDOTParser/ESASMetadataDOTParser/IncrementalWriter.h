@@ -0,0 +1,78 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef IncrementalWriter_h
+#define IncrementalWriter_h
+
+#include "Graph.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Writer for --watch, which writes the diagram of the same graph to the
+ * same file after every change to the metadata.
+ *
+ * Every write goes to fileName.tmp, which then replaces fileName, so the
+ * file is never seen half written and a link to it keeps the old diagram.
+ * While the graph prints the whole model, see Graph::prints_whole_model(),
+ * the writer notes where every table and arrow went and the hash of the
+ * file.
+ *
+ * If the next write finds the file as it was left, by size and hash, and
+ * the model has changed by one Graph::replace() since, the tables and
+ * arrows that did not change are copied from the old file in runs, and
+ * only the new and changed ones are rendered.
+ */
+class IncrementalWriter {
+  public:
+    explicit IncrementalWriter( std::string fileName );
+
+    bool write( Graph &graph, unsigned threads = 1 );
+
+    const std::string &error() const { return errorText; }
+    bool patched() const { return lastPatched; } // Whether the last write copied from the file before
+
+  private:
+    using Span = std::pair<uint64_t, uint32_t>; // Offset and length in the file, length 0 if not in it
+
+    bool print( Graph &graph, bool whole, unsigned threads, const std::string &temporary );
+    bool patch( const Graph &graph, std::string_view last, const std::string &temporary );
+    bool fail( const std::string &temporary, const std::string &text );
+
+    std::string fileName;
+    std::string errorText;
+    bool lastPatched = false;
+
+    // The file as written last, if that was the whole model --
+    bool known = false;
+    uint64_t revision = 0; // Graph::revision() written
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    std::vector<Span> tables; // By entity row
+    std::vector<Span> arrows; // By edge row
+};
+
+#endif /* IncrementalWriter_h */
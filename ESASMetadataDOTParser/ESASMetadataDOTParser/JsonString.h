@@ -0,0 +1,66 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef JsonString_h
+#define JsonString_h
+
+#include <ostream>
+#include <string_view>
+
+/**
+ * Writes text as a JSON string. Names and types come from XML attributes
+ * and inputs from the command line, which may hold quotes, backslashes and
+ * control characters.
+ */
+inline void print_json_string( std::ostream &stream, std::string_view text ) {
+    stream << '"';
+    for ( char c : text ) {
+        switch ( c ) {
+        case '"':
+            stream << "\\\"";
+            break;
+        case '\\':
+            stream << "\\\\";
+            break;
+        case '\n':
+            stream << "\\n";
+            break;
+        case '\r':
+            stream << "\\r";
+            break;
+        case '\t':
+            stream << "\\t";
+            break;
+        default:
+            if ( static_cast<unsigned char>( c ) < 0x20 ) {
+                constexpr auto &hex = "0123456789abcdef";
+                stream << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+            } else {
+                stream << c;
+            }
+        }
+    }
+    stream << '"';
+}
+
+#endif /* JsonString_h */
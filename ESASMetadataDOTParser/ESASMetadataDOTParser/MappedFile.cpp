@@ -0,0 +1,92 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "MappedFile.h"
+#include <cstdio>
+
+#if !defined( _WIN32 ) && ( defined( __unix__ ) || defined( __APPLE__ ) )
+#define HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open( const char *fileName ) {
+    close();
+
+#ifdef HAS_MMAP
+    int fd = ::open( fileName, O_RDONLY );
+    if ( fd < 0 ) {
+        return false;
+    }
+    struct stat info;
+    if ( fstat( fd, &info ) == 0 && S_ISREG( info.st_mode ) ) {
+        length = static_cast<size_t>( info.st_size );
+        if ( length == 0 ) {
+            ::close( fd );
+            return true;
+        }
+        void *region = mmap( nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( region != MAP_FAILED ) {
+            ::close( fd );
+            mapped = static_cast<const char *>( region );
+            return true;
+        }
+    }
+    ::close( fd );
+    length = 0;
+#endif
+
+    // Not mappable (or no mmap), read the whole file instead --
+
+    FILE *fp = fopen( fileName, "rb" );
+    if ( fp == nullptr ) {
+        return false;
+    }
+    char block[64 * 1024];
+    size_t count;
+    while ( ( count = fread( block, 1, sizeof( block ), fp ) ) > 0 ) {
+        copy.insert( copy.end(), block, block + count );
+    }
+    bool ok = ferror( fp ) == 0;
+    fclose( fp );
+    length = copy.size();
+    return ok;
+}
+
+void MappedFile::close() {
+#ifdef HAS_MMAP
+    if ( mapped != nullptr ) {
+        munmap( const_cast<char *>( mapped ), length );
+    }
+#endif
+    mapped = nullptr;
+    length = 0;
+    copy.clear();
+}
@@ -0,0 +1,387 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "ModelDiff.h"
+#include "ContentHash.h"
+#include "DotWriter.h"
+#include "Graph.h"
+#include "JsonString.h"
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+const char *change_name( ModelDiff::Change change ) {
+    switch ( change ) {
+    case ModelDiff::Change::Added:
+        return "added";
+    case ModelDiff::Change::Removed:
+        return "removed";
+    case ModelDiff::Change::Changed:
+        return "changed";
+    default:
+        return "same";
+    }
+}
+
+/**
+ * Walks the properties of an entity in both models, which are sorted by
+ * name, and calls visit( i, j ) once per name with the property rows in
+ * old and now, None for the side that lacks it.
+ */
+template <typename Visit>
+void merge_properties( const EDMModel &old, uint32_t oldEntity, const EDMModel &now, uint32_t newEntity, Visit visit ) {
+    auto oldProperties = old.properties( oldEntity );
+    auto newProperties = now.properties( newEntity );
+    uint32_t i = oldProperties.begin;
+    uint32_t j = newProperties.begin;
+    while ( i < oldProperties.end || j < newProperties.end ) {
+        int order = i == oldProperties.end ? 1 : j == newProperties.end ? -1 : old.strings[old.propertyNames[i]].compare( now.strings[now.propertyNames[j]] );
+        if ( order < 0 ) {
+            visit( i++, ModelDiff::None );
+        } else if ( order > 0 ) {
+            visit( ModelDiff::None, j++ );
+        } else {
+            visit( i++, j++ );
+        }
+    }
+}
+
+} // namespace
+
+ModelDiff::Side::Side( const EDMModel &model ) : model( model ) {
+    stringHashes.resize( model.strings.size() );
+    for ( size_t id = 0; id < stringHashes.size(); ++id ) {
+        auto text = model.strings[static_cast<EDMModel::Id>( id )];
+        stringHashes[id] = content_hash( text.data(), text.size() );
+    }
+
+    // Edges by source entity, as in Adjacency::fill() --
+
+    edgeOffsets.assign( model.entity_count() + 1, 0 );
+    for ( uint32_t edge = 0; edge < model.edge_count(); ++edge ) {
+        ++edgeOffsets[model.edgeSources[edge] + 1];
+    }
+    for ( uint32_t entity = 0; entity < model.entity_count(); ++entity ) {
+        edgeOffsets[entity + 1] += edgeOffsets[entity];
+    }
+    edgeKeys.resize( model.edge_count() );
+    vector<uint32_t> next( edgeOffsets.begin(), edgeOffsets.end() - 1 );
+    for ( uint32_t edge = 0; edge < model.edge_count(); ++edge ) {
+        uint64_t key = hash_combine( stringHashes[model.edgeSourceFields[edge]], stringHashes[model.edgeTargets[edge]] );
+        edgeKeys[next[model.edgeSources[edge]]++] = {hash_combine( key, stringHashes[model.edgeTargetFields[edge]] ), edge};
+    }
+
+    // Properties are sorted by name already; edges are sorted here, so declaration order does not count --
+
+    entityHashes.resize( model.entity_count() );
+    for ( uint32_t entity = 0; entity < model.entity_count(); ++entity ) {
+        uint64_t hash = 0;
+        auto properties = model.properties( entity );
+        for ( uint32_t row = properties.begin; row < properties.end; ++row ) {
+            hash = hash_combine( hash_combine( hash, stringHashes[model.propertyNames[row]] ), stringHashes[model.propertyTypes[row]] );
+        }
+        auto first = edgeKeys.begin() + edgeOffsets[entity];
+        auto last = edgeKeys.begin() + edgeOffsets[entity + 1];
+        sort( first, last );
+        for ( auto edge = first; edge != last; ++edge ) {
+            hash = hash_combine( hash, edge->first );
+        }
+        entityHashes[entity] = hash;
+    }
+}
+
+ModelDiff::ModelDiff( const EDMModel &before, const EDMModel &after ) : before( before ), after( after ) {
+}
+
+void ModelDiff::compare() {
+    const auto &old = before.model;
+    const auto &now = after.model;
+
+    entityChanges.clear();
+    propertyChanges.clear();
+    edgeChanges.clear();
+    beforeEntities.assign( old.entity_count(), None );
+    afterEntities.assign( now.entity_count(), None );
+
+    // Entities of before by name; entities sharing a name are matched in document order --
+
+    unordered_map<string_view, uint32_t> firstOfName;
+    firstOfName.reserve( old.entity_count() );
+    vector<uint32_t> nextOfName( old.entity_count(), None );
+    for ( uint32_t entity = old.entity_count(); entity-- > 0; ) {
+        auto inserted = firstOfName.emplace( old.strings[old.entityNames[entity]], entity );
+        if ( !inserted.second ) {
+            nextOfName[entity] = inserted.first->second;
+            inserted.first->second = entity;
+        }
+    }
+
+    for ( uint32_t entity = 0; entity < now.entity_count(); ++entity ) {
+        afterEntities[entity] = static_cast<uint32_t>( entityChanges.size() );
+        auto found = firstOfName.find( now.strings[now.entityNames[entity]] );
+        if ( found == firstOfName.end() || found->second == None ) {
+            entityChanges.push_back( {Change::Added, None, entity} );
+            add_edges( after, entity, Change::Added );
+            continue;
+        }
+        uint32_t match = found->second;
+        found->second = nextOfName[match];
+        beforeEntities[match] = afterEntities[entity];
+        entityChanges.push_back( {Change::Same, match, entity} );
+        if ( before.entityHashes[match] != after.entityHashes[entity] ) {
+            compare_entity( match, entity );
+        }
+    }
+
+    for ( uint32_t entity = 0; entity < old.entity_count(); ++entity ) {
+        if ( beforeEntities[entity] == None ) {
+            beforeEntities[entity] = static_cast<uint32_t>( entityChanges.size() );
+            entityChanges.push_back( {Change::Removed, entity, None} );
+            add_edges( before, entity, Change::Removed );
+        }
+    }
+}
+
+/**
+ * Records every edge of an added or removed entity.
+ */
+void ModelDiff::add_edges( const Side &side, uint32_t entity, Change change ) {
+    uint32_t index = static_cast<uint32_t>( entityChanges.size() - 1 );
+    for ( uint32_t i = side.edgeOffsets[entity]; i < side.edgeOffsets[entity + 1]; ++i ) {
+        edgeChanges.push_back( {index, change, side.edgeKeys[i].second} );
+    }
+}
+
+/**
+ * Merges the properties and the edges of an entity present in both models.
+ * Marks it changed if anything differs.
+ */
+void ModelDiff::compare_entity( uint32_t oldEntity, uint32_t newEntity ) {
+    const auto &old = before.model;
+    const auto &now = after.model;
+    uint32_t index = static_cast<uint32_t>( entityChanges.size() - 1 );
+    size_t changes = propertyChanges.size() + edgeChanges.size();
+
+    merge_properties( old, oldEntity, now, newEntity, [&]( uint32_t i, uint32_t j ) {
+        if ( j == None ) {
+            propertyChanges.push_back( {index, Change::Removed, i, None} );
+        } else if ( i == None ) {
+            propertyChanges.push_back( {index, Change::Added, None, j} );
+        } else if ( old.strings[old.propertyTypes[i]] != now.strings[now.propertyTypes[j]] ) {
+            propertyChanges.push_back( {index, Change::Changed, i, j} );
+        }
+    } );
+
+    auto oldEdge = before.edgeKeys.begin() + before.edgeOffsets[oldEntity];
+    auto oldEnd = before.edgeKeys.begin() + before.edgeOffsets[oldEntity + 1];
+    auto newEdge = after.edgeKeys.begin() + after.edgeOffsets[newEntity];
+    auto newEnd = after.edgeKeys.begin() + after.edgeOffsets[newEntity + 1];
+    while ( oldEdge != oldEnd || newEdge != newEnd ) {
+        if ( newEdge == newEnd || ( oldEdge != oldEnd && oldEdge->first < newEdge->first ) ) {
+            edgeChanges.push_back( {index, Change::Removed, ( oldEdge++ )->second} );
+        } else if ( oldEdge == oldEnd || newEdge->first < oldEdge->first ) {
+            edgeChanges.push_back( {index, Change::Added, ( newEdge++ )->second} );
+        } else {
+            ++oldEdge;
+            ++newEdge;
+        }
+    }
+
+    if ( propertyChanges.size() + edgeChanges.size() > changes ) {
+        entityChanges.back().change = Change::Changed;
+    }
+}
+
+size_t ModelDiff::count( Change change ) const {
+    return static_cast<size_t>( count_if( entityChanges.begin(), entityChanges.end(), [&]( const Entity &entity ) { return entity.change == change; } ) );
+}
+
+/**
+ * Unchanged entities look as in Graph::render_table(). Added and removed
+ * entities are green and red, changed ones yellow with their added, removed
+ * and retyped properties marked the same way.
+ */
+void ModelDiff::render_table( const Entity &entity, string &out ) const {
+    TableStyle style;
+    switch ( entity.change ) {
+    case Change::Added:
+        style = {"\'darkgreen\'", "\'palegreen\'", "honeydew", "filled"};
+        break;
+    case Change::Removed:
+        style = {"\'red\'", "\'lightpink\'", "mistyrose", "\"filled,dashed\""};
+        break;
+    case Change::Changed:
+        style = {"\'darkgoldenrod\'", "\'khaki\'", "lightyellow", "filled"};
+        break;
+    default:
+        break;
+    }
+
+    const auto &model = entity.after != None ? after.model : before.model;
+    uint32_t row = entity.after != None ? entity.after : entity.before;
+    open_table( out, model.strings[model.entityNames[row]], style );
+
+    if ( entity.change != Change::Changed ) {
+        auto properties = model.properties( row );
+        for ( uint32_t i = properties.begin; i < properties.end; ++i ) {
+            add_table_row( out, model.strings[model.propertyNames[i]], model.strings[model.propertyTypes[i]] );
+        }
+    } else {
+        const auto &old = before.model;
+        const auto &now = after.model;
+        merge_properties( old, entity.before, now, entity.after, [&]( uint32_t i, uint32_t j ) {
+            if ( j == None ) {
+                add_table_row( out, old.strings[old.propertyNames[i]], old.strings[old.propertyTypes[i]], "lightpink", true );
+            } else if ( i == None ) {
+                add_table_row( out, now.strings[now.propertyNames[j]], now.strings[now.propertyTypes[j]], "palegreen" );
+            } else {
+                auto oldType = old.strings[old.propertyTypes[i]];
+                auto newType = now.strings[now.propertyTypes[j]];
+                if ( oldType == newType ) {
+                    add_table_row( out, now.strings[now.propertyNames[j]], newType );
+                } else {
+                    string types;
+                    append_to_string( types, "<S>", oldType, "</S> ", newType );
+                    add_table_row( out, now.strings[now.propertyNames[j]], types, "khaki" );
+                }
+            }
+        } );
+    }
+    close_table( out, style );
+}
+
+void ModelDiff::print_graph( ostream &stream ) const {
+    const auto &old = before.model;
+    const auto &now = after.model;
+
+    // Changed entities, and the unchanged ones that changed edges lead to --
+
+    vector<bool> shown( entityChanges.size() );
+    for ( size_t i = 0; i < entityChanges.size(); ++i ) {
+        shown[i] = entityChanges[i].change != Change::Same;
+    }
+    vector<bool> added( now.edge_count() );
+    for ( const auto &edge : edgeChanges ) {
+        shown[edge.entity] = true;
+        const auto &model = edge.change == Change::Added ? now : old;
+        const auto &rows = edge.change == Change::Added ? afterEntities : beforeEntities;
+        if ( model.edgeTargetRows[edge.row] != EDMModel::NoEntity ) {
+            shown[rows[model.edgeTargetRows[edge.row]]] = true;
+        }
+        if ( edge.change == Change::Added ) {
+            added[edge.row] = true;
+        }
+    }
+
+    DotWriter writer( stream );
+    auto &out = writer.buffer();
+    out.append( "digraph Data {\n" );
+    for ( size_t i = 0; i < entityChanges.size(); ++i ) {
+        if ( shown[i] ) {
+            render_table( entityChanges[i], out );
+            out.push_back( '\n' );
+            writer.commit();
+        }
+    }
+
+    auto arrow = [&]( const EDMModel &model, uint32_t edge, const char *attributes ) {
+        append_to_string( out, model.strings[model.edge_source_name( edge )], ":", model.strings[model.edgeSourceFields[edge]], " -> ",
+                          model.strings[model.edgeTargets[edge]], ":", model.strings[model.edgeTargetFields[edge]], attributes, "\n" );
+        writer.commit();
+    };
+
+    // Edges of after between shown entities, then the removed ones --
+
+    for ( uint32_t edge = 0; edge < now.edge_count(); ++edge ) {
+        uint32_t target = now.edgeTargetRows[edge];
+        if ( target == EDMModel::NoEntity || !shown[afterEntities[now.edgeSources[edge]]] || !shown[afterEntities[target]] ) {
+            continue;
+        }
+        arrow( now, edge, added[edge] ? " [color=darkgreen penwidth=2]" : "" );
+    }
+    for ( const auto &edge : edgeChanges ) {
+        if ( edge.change == Change::Removed && old.edgeTargetRows[edge.row] != EDMModel::NoEntity ) {
+            arrow( old, edge.row, " [color=red style=dashed]" );
+        }
+    }
+    out.append( "}\n" );
+
+    writer.finish();
+}
+
+void ModelDiff::print_json( ostream &stream ) const {
+    const auto &old = before.model;
+    const auto &now = after.model;
+
+    auto entity_name = [&]( const Entity &entity ) {
+        return entity.after != None ? now.strings[now.entityNames[entity.after]] : old.strings[old.entityNames[entity.before]];
+    };
+
+    stream << "{\n  \"entities\": {\"added\": " << count( Change::Added ) << ", \"removed\": " << count( Change::Removed )
+           << ", \"changed\": " << count( Change::Changed ) << ", \"same\": " << count( Change::Same ) << "},\n  \"changes\": [";
+
+    const char *separator = "\n";
+    for ( const auto &entity : entityChanges ) {
+        if ( entity.change == Change::Added || entity.change == Change::Removed ) {
+            stream << separator << "    {\"change\": \"" << change_name( entity.change ) << "\", \"kind\": \"entity\", \"entity\": ";
+            print_json_string( stream, entity_name( entity ) );
+            stream << "}";
+            separator = ",\n";
+        }
+    }
+    for ( const auto &property : propertyChanges ) {
+        stream << separator << "    {\"change\": \"" << change_name( property.change ) << "\", \"kind\": \"property\", \"entity\": ";
+        print_json_string( stream, entity_name( entityChanges[property.entity] ) );
+        stream << ", \"property\": ";
+        print_json_string( stream, property.after != None ? now.strings[now.propertyNames[property.after]] : old.strings[old.propertyNames[property.before]] );
+        if ( property.before != None ) {
+            stream << ", \"before\": ";
+            print_json_string( stream, old.strings[old.propertyTypes[property.before]] );
+        }
+        if ( property.after != None ) {
+            stream << ", \"after\": ";
+            print_json_string( stream, now.strings[now.propertyTypes[property.after]] );
+        }
+        stream << "}";
+        separator = ",\n";
+    }
+    for ( const auto &edge : edgeChanges ) {
+        const auto &model = edge.change == Change::Added ? now : old;
+        stream << separator << "    {\"change\": \"" << change_name( edge.change ) << "\", \"kind\": \"edge\", \"entity\": ";
+        print_json_string( stream, entity_name( entityChanges[edge.entity] ) );
+        stream << ", \"property\": ";
+        print_json_string( stream, model.strings[model.edgeSourceFields[edge.row]] );
+        stream << ", \"target\": ";
+        print_json_string( stream, model.strings[model.edgeTargets[edge.row]] );
+        stream << ", \"targetProperty\": ";
+        print_json_string( stream, model.strings[model.edgeTargetFields[edge.row]] );
+        stream << "}";
+        separator = ",\n";
+    }
+    stream << "\n  ]\n}" << endl;
+}
@@ -0,0 +1,121 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef ModelDiff_h
+#define ModelDiff_h
+
+#include "EDMModel.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Structural differences between two resolved models, for --diff.
+ *
+ * Entities are matched by the name they are shown under. Every entity gets
+ * a hash over its properties and navigation edges, so entities with equal
+ * hashes are passed over; only the others have their properties (sorted by
+ * name in both models) and edges (sorted by hash) merged against each
+ * other. Everything is linear in the size of the models apart from the
+ * sorting of each entity's edges.
+ *
+ * The changes refer to rows of both models, which must outlive the diff.
+ */
+class ModelDiff {
+  public:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    enum class Change : uint8_t { Same, Added, Removed, Changed };
+
+    struct Entity {
+        Change change;
+        uint32_t before; // Entity row in before, None if added
+        uint32_t after;  // Entity row in after, None if removed
+    };
+
+    struct Property {
+        uint32_t entity; // Index into entities()
+        Change change;
+        uint32_t before; // Property row in before, None if added
+        uint32_t after;  // Property row in after, None if removed
+    };
+
+    struct Edge {
+        uint32_t entity; // Index into entities()
+        Change change;   // Added or Removed
+        uint32_t row;    // Edge row in after if added, in before if removed
+    };
+
+    ModelDiff( const EDMModel &before, const EDMModel &after );
+
+    void compare();
+
+    /**
+     * The added, removed and changed entities, and the unchanged entities at
+     * the ends of added or removed edges, with their edges between them.
+     */
+    void print_graph( std::ostream &stream ) const;
+
+    /**
+     * The change list as JSON.
+     */
+    void print_json( std::ostream &stream ) const;
+
+    const std::vector<Entity> &entities() const { return entityChanges; } // Unchanged ones too
+    const std::vector<Property> &properties() const { return propertyChanges; }
+    const std::vector<Edge> &edges() const { return edgeChanges; }
+    size_t count( Change change ) const;
+
+  private:
+    /**
+     * Per model: the hash of every string and every entity, and the edges of
+     * every entity as a slice of (hash, edge row) pairs sorted by hash.
+     */
+    struct Side {
+        explicit Side( const EDMModel &model );
+
+        const EDMModel &model;
+        std::vector<uint64_t> stringHashes;
+        std::vector<uint64_t> entityHashes;
+        std::vector<uint32_t> edgeOffsets; // Entities + 1 entries
+        std::vector<std::pair<uint64_t, uint32_t>> edgeKeys;
+    };
+
+    void compare_entity( uint32_t before, uint32_t after );
+    void add_edges( const Side &side, uint32_t entity, Change change );
+    void render_table( const Entity &entity, std::string &out ) const;
+
+    Side before;
+    Side after;
+    std::vector<Entity> entityChanges; // Every entity of after in document order, then the removed ones
+    std::vector<Property> propertyChanges;
+    std::vector<Edge> edgeChanges;
+    std::vector<uint32_t> beforeEntities; // Entity row -> index into entities()
+    std::vector<uint32_t> afterEntities;
+};
+
+#endif /* ModelDiff_h */
@@ -0,0 +1,326 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "ModelSnapshot.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <system_error>
+
+using namespace std;
+
+namespace {
+
+constexpr char Magic[8] = {'E', 'S', 'A', 'S', 'M', 'D', 'L', '\0'};
+constexpr uint32_t ByteOrder = 0x01020304; // Reads differently on a machine of the other byte order
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t inputHash;
+};
+
+struct ArrayHeader {
+    uint64_t count;
+    uint32_t elementSize;
+    uint32_t reserved;
+};
+
+constexpr size_t Alignment = 8;
+
+class Writer {
+  public:
+    explicit Writer( ostream &stream ) : stream( stream ) {}
+
+    void put( const void *data, size_t size ) {
+        stream.write( static_cast<const char *>( data ), static_cast<streamsize>( size ) );
+        offset += size;
+    }
+
+    template <typename T>
+    void array( const T *data, size_t count ) {
+        static const char padding[Alignment] = {};
+        ArrayHeader header{count, sizeof( T ), 0};
+        put( &header, sizeof( header ) );
+        put( data, count * sizeof( T ) );
+        put( padding, ( Alignment - offset % Alignment ) % Alignment );
+    }
+
+    template <typename T>
+    void array( const vector<T> &rows ) {
+        array( rows.data(), rows.size() );
+    }
+
+  private:
+    ostream &stream;
+    size_t offset = 0;
+};
+
+/**
+ * Walks the arrays of a mapped snapshot. Every read is bounds checked, so a
+ * truncated or foreign file fails instead of reading past the mapping.
+ */
+class Reader {
+  public:
+    Reader( const char *data, size_t size ) : data( data ), size( size ) {}
+
+    template <typename T>
+    const T *array( size_t &count ) {
+        ArrayHeader header;
+        if ( size - offset < sizeof( header ) ) {
+            return nullptr;
+        }
+        memcpy( &header, data + offset, sizeof( header ) );
+        size_t begin = offset + sizeof( header );
+        if ( header.elementSize != sizeof( T ) || header.count > ( size - begin ) / sizeof( T ) ) {
+            return nullptr;
+        }
+        count = static_cast<size_t>( header.count );
+        size_t end = begin + count * sizeof( T );
+        offset = min( size, end + ( Alignment - end % Alignment ) % Alignment );
+        return reinterpret_cast<const T *>( data + begin );
+    }
+
+    template <typename T>
+    bool array( vector<T> &rows ) {
+        size_t count = 0;
+        const T *first = array<T>( count );
+        if ( first == nullptr ) {
+            return false;
+        }
+        rows.assign( first, first + count );
+        return true;
+    }
+
+    size_t offset = sizeof( Header );
+
+  private:
+    const char *data;
+    size_t size;
+};
+
+} // namespace
+
+string ModelSnapshot::file_name( const string &directory, uint64_t hash ) {
+    char name[32];
+    snprintf( name, sizeof( name ), "%016llx.model", static_cast<unsigned long long>( hash ) );
+    return ( filesystem::path( directory ) / name ).string();
+}
+
+/**
+ * Writes to a temporary file next to fileName and renames it into place, so
+ * a reader never sees half a snapshot.
+ */
+bool ModelSnapshot::save( const EDMModel &model, uint64_t inputHash, const string &fileName ) {
+    string temporary = fileName + ".tmp";
+    {
+        ofstream stream( temporary, ios::binary | ios::trunc );
+        if ( !stream.is_open() ) {
+            errorText = "couldn't create " + temporary;
+            return false;
+        }
+
+        Header header{};
+        memcpy( header.magic, Magic, sizeof( Magic ) );
+        header.version = Version;
+        header.byteOrder = ByteOrder;
+        header.inputHash = inputHash;
+
+        Writer writer( stream );
+        writer.put( &header, sizeof( header ) );
+
+        // Strings back to back with their end offsets, and the hash slots --
+
+        const auto &strings = model.strings;
+        vector<char> characters;
+        vector<uint32_t> ends;
+        ends.reserve( strings.size() );
+        for ( StringTable::Id id = 0; id < strings.size(); ++id ) {
+            auto text = strings[id];
+            characters.insert( characters.end(), text.begin(), text.end() );
+            ends.push_back( static_cast<uint32_t>( characters.size() ) );
+        }
+        writer.array( characters );
+        writer.array( ends );
+        writer.array( strings.hash_slots() );
+
+        // Rows, in declaration order --
+
+        writer.array( model.schemaNamespaces );
+        writer.array( model.schemaAliases );
+        writer.array( model.entityNames );
+        writer.array( model.entityTypeNames );
+        writer.array( model.entityNamespaces );
+        writer.array( model.entityProperties );
+        writer.array( model.propertyNames );
+        writer.array( model.propertyTypes );
+        writer.array( model.edgeSources );
+        writer.array( model.edgeSourceFields );
+        writer.array( model.edgeTargets );
+        writer.array( model.edgeTargetTypes );
+        writer.array( model.edgeTargetRows );
+        writer.array( model.edgeTargetFields );
+        writer.array( model.entitySetNames );
+        writer.array( model.entitySetTypes );
+        writer.array( model.entitySetRows );
+
+        // Symbol tables --
+
+        vector<uint64_t> keys;
+        vector<uint32_t> rows;
+        for ( const auto &slot : model.entityIndex ) {
+            keys.push_back( slot.first );
+            rows.push_back( slot.second );
+        }
+        writer.array( model.namespaceOfQualifier );
+        writer.array( keys );
+        writer.array( rows );
+
+        stream.flush();
+        if ( !stream ) {
+            errorText = "couldn't write " + temporary;
+            return false;
+        }
+    }
+
+    error_code error;
+    filesystem::rename( temporary, fileName, error );
+    if ( error ) {
+        filesystem::remove( temporary, error );
+        errorText = "couldn't write " + fileName;
+        return false;
+    }
+    return true;
+}
+
+bool ModelSnapshot::load( EDMModel &model, uint64_t inputHash, const string &fileName ) {
+    auto file = make_shared<MappedFile>();
+    if ( !file->open( fileName.c_str() ) ) {
+        errorText = "no snapshot " + fileName;
+        return false;
+    }
+
+    Header header;
+    if ( file->size() < sizeof( header ) ) {
+        errorText = fileName + " is not a snapshot";
+        return false;
+    }
+    memcpy( &header, file->data(), sizeof( header ) );
+    if ( memcmp( header.magic, Magic, sizeof( Magic ) ) != 0 || header.byteOrder != ByteOrder ) {
+        errorText = fileName + " is not a snapshot";
+        return false;
+    }
+    if ( header.version != Version ) {
+        errorText = fileName + " is from another version";
+        return false;
+    }
+    if ( header.inputHash != inputHash ) {
+        errorText = fileName + " is for other metadata";
+        return false;
+    }
+
+    Reader reader( file->data(), file->size() );
+    EDMModel loaded;
+
+    size_t characterCount = 0, stringCount = 0;
+    const char *characters = reader.array<char>( characterCount );
+    const uint32_t *ends = reader.array<uint32_t>( stringCount );
+    vector<StringTable::Id> slots;
+    bool ok = characters != nullptr && ends != nullptr && reader.array( slots );
+
+    // The string table must be consistent before it is used for anything --
+
+    for ( size_t id = 0; ok && id < stringCount; ++id ) {
+        ok = ends[id] <= characterCount && ( id == 0 || ends[id - 1] <= ends[id] );
+    }
+    ok = ok && slots.size() >= 2 * stringCount && ( slots.size() & ( slots.size() - 1 ) ) == 0;
+    for ( size_t slot = 0; ok && slot < slots.size(); ++slot ) {
+        ok = slots[slot] <= stringCount;
+    }
+
+    vector<uint64_t> keys;
+    vector<uint32_t> rows;
+    ok = ok && reader.array( loaded.schemaNamespaces ) && reader.array( loaded.schemaAliases ) && reader.array( loaded.entityNames ) &&
+         reader.array( loaded.entityTypeNames ) && reader.array( loaded.entityNamespaces ) && reader.array( loaded.entityProperties ) &&
+         reader.array( loaded.propertyNames ) && reader.array( loaded.propertyTypes ) && reader.array( loaded.edgeSources ) &&
+         reader.array( loaded.edgeSourceFields ) && reader.array( loaded.edgeTargets ) && reader.array( loaded.edgeTargetTypes ) &&
+         reader.array( loaded.edgeTargetRows ) && reader.array( loaded.edgeTargetFields ) && reader.array( loaded.entitySetNames ) &&
+         reader.array( loaded.entitySetTypes ) && reader.array( loaded.entitySetRows ) && reader.array( loaded.namespaceOfQualifier ) &&
+         reader.array( keys ) && reader.array( rows );
+
+    // Row counts must agree with each other --
+
+    size_t entities = loaded.entityNames.size();
+    size_t edges = loaded.edgeSources.size();
+    ok = ok && loaded.schemaAliases.size() == loaded.schemaNamespaces.size() && loaded.entityTypeNames.size() == entities &&
+         loaded.entityNamespaces.size() == entities &&
+         loaded.entityProperties.size() == entities + 1 && loaded.entityProperties.back() == loaded.propertyNames.size() &&
+         loaded.propertyTypes.size() == loaded.propertyNames.size() && loaded.edgeSourceFields.size() == edges &&
+         loaded.edgeTargets.size() == edges && loaded.edgeTargetTypes.size() == edges && loaded.edgeTargetRows.size() == edges &&
+         loaded.edgeTargetFields.size() == edges && loaded.entitySetTypes.size() == loaded.entitySetNames.size() &&
+         loaded.entitySetRows.size() == loaded.entitySetNames.size() &&
+         loaded.namespaceOfQualifier.size() == stringCount && keys.size() == rows.size() && ( keys.size() & ( keys.size() - 1 ) ) == 0;
+
+    // And every id and row must be in range, so rendering can trust them --
+
+    // None and NoEntity are both UINT32_MAX, allowed where optional --
+
+    auto below = [&]( const vector<uint32_t> &values, size_t limit, bool optional = false ) {
+        for ( uint32_t value : values ) {
+            if ( value >= limit && !( optional && value == StringTable::None ) ) {
+                return false;
+            }
+        }
+        return true;
+    };
+    ok = ok && below( loaded.schemaNamespaces, stringCount ) && below( loaded.schemaAliases, stringCount, true ) &&
+         below( loaded.entityNames, stringCount ) && below( loaded.entityTypeNames, stringCount ) &&
+         below( loaded.entityNamespaces, stringCount, true ) &&
+         below( loaded.entityProperties, loaded.propertyNames.size() + 1 ) && below( loaded.propertyNames, stringCount ) &&
+         below( loaded.propertyTypes, stringCount ) && below( loaded.edgeSources, entities ) && below( loaded.edgeSourceFields, stringCount ) &&
+         below( loaded.edgeTargets, stringCount ) && below( loaded.edgeTargetTypes, stringCount ) && below( loaded.edgeTargetRows, entities, true ) &&
+         below( loaded.edgeTargetFields, stringCount ) && below( loaded.entitySetNames, stringCount ) && below( loaded.entitySetTypes, stringCount ) &&
+         below( loaded.entitySetRows, entities, true ) &&
+         below( loaded.namespaceOfQualifier, stringCount, true ) && below( rows, entities, true );
+    for ( size_t entity = 0; ok && entity < entities; ++entity ) {
+        ok = loaded.entityProperties[entity] <= loaded.entityProperties[entity + 1];
+    }
+    if ( !ok ) {
+        errorText = fileName + " is damaged";
+        return false;
+    }
+
+    loaded.entityIndex.resize( keys.size() );
+    for ( size_t slot = 0; slot < keys.size(); ++slot ) {
+        loaded.entityIndex[slot] = {keys[slot], rows[slot]};
+    }
+    loaded.strings.restore( characters, ends, stringCount, move( slots ), file );
+
+    model = move( loaded );
+    return true;
+}
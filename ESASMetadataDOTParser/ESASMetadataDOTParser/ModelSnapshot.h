@@ -0,0 +1,61 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef ModelSnapshot_h
+#define ModelSnapshot_h
+
+#include "EDMModel.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Binary snapshot of a resolved EDMModel, so metadata that has not changed
+ * since the last run need not be parsed again.
+ *
+ * The file is a header followed by every row vector and the string table as
+ * flat arrays, each 8 byte aligned. load() maps the file, borrows the
+ * string characters straight from the mapping and restores the rows with
+ * one bulk copy each; nothing is parsed. The header carries a format
+ * version and the content hash of the metadata the model was read from, and
+ * a snapshot is only used when both match, see content_hash().
+ */
+class ModelSnapshot {
+  public:
+    static constexpr uint32_t Version = 2; // Bump on any change to the layout or to what the model holds
+
+    /**
+     * File name of the snapshot for an input with hash in directory.
+     */
+    static std::string file_name( const std::string &directory, uint64_t hash );
+
+    bool save( const EDMModel &model, uint64_t inputHash, const std::string &fileName );
+    bool load( EDMModel &model, uint64_t inputHash, const std::string &fileName );
+
+    const std::string &error() const { return errorText; }
+
+  private:
+    std::string errorText;
+};
+
+#endif /* ModelSnapshot_h */
@@ -0,0 +1,260 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "ParallelReader.h"
+#include "ContentHash.h"
+#include "EDM.h"
+#include "Graph.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "tinyxml2.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+using namespace tinyxml2;
+
+namespace {
+
+bool is_tag( string_view xml, size_t position, string_view name ) {
+    if ( xml.compare( position, name.size(), name ) != 0 || position + name.size() >= xml.size() ) {
+        return false;
+    }
+    char next = xml[position + name.size()];
+    return next == '>' || next == '/' || next == ' ' || next == '\t' || next == '\r' || next == '\n';
+}
+
+// Index just past the '>' that closes the start tag at position, honouring quotes --
+size_t tag_end( string_view xml, size_t position ) {
+    char quote = 0;
+    for ( size_t i = position + 1; i < xml.size(); ++i ) {
+        char c = xml[i];
+        if ( quote != 0 ) {
+            if ( c == quote ) {
+                quote = 0;
+            }
+        } else if ( c == '"' || c == '\'' ) {
+            quote = c;
+        } else if ( c == '>' ) {
+            return i + 1;
+        }
+    }
+    return xml.size();
+}
+
+// Index just past the element starting at position, which cannot nest in itself --
+size_t element_end( string_view xml, size_t position, string_view endTag ) {
+    size_t end = tag_end( xml, position );
+    if ( xml[end - 1] == '>' && xml[end - 2] == '/' ) {
+        return end;
+    }
+    size_t close = xml.find( endTag, end );
+    if ( close == string_view::npos ) {
+        return xml.size();
+    }
+    size_t closeEnd = xml.find( '>', close );
+    return closeEnd == string_view::npos ? xml.size() : closeEnd + 1;
+}
+
+size_t skip_past( string_view xml, size_t position, string_view terminator ) {
+    size_t found = xml.find( terminator, position );
+    return found == string_view::npos ? xml.size() : found + terminator.size();
+}
+
+// Raw value of an attribute in a start tag, or an empty view --
+string_view attribute_value( string_view tag, string_view name ) {
+    for ( size_t position = tag.find( name ); position != string_view::npos; position = tag.find( name, position + 1 ) ) {
+        size_t i = position + name.size();
+        if ( position == 0 || !isspace( static_cast<unsigned char>( tag[position - 1] ) ) ) {
+            continue;
+        }
+        while ( i < tag.size() && isspace( static_cast<unsigned char>( tag[i] ) ) ) {
+            ++i;
+        }
+        if ( i == tag.size() || tag[i] != '=' ) {
+            continue;
+        }
+        do {
+            ++i;
+        } while ( i < tag.size() && isspace( static_cast<unsigned char>( tag[i] ) ) );
+        if ( i == tag.size() || ( tag[i] != '"' && tag[i] != '\'' ) ) {
+            return {};
+        }
+        size_t close = tag.find( tag[i], i + 1 );
+        return close == string_view::npos ? string_view{} : tag.substr( i + 1, close - i - 1 );
+    }
+    return {};
+}
+
+} // namespace
+
+ParallelReader::ParallelReader( Graph &graph, unsigned threads ) : graph( graph ), threadCount( max( 1u, threads ) ) {
+}
+
+void ParallelReader::scan( string_view xml, size_t targetSize, vector<Range> &entityChunks, vector<Range> &containers, bool contentDefined,
+                           Span *span ) {
+    constexpr size_t none = string_view::npos;
+    size_t chunkBegin = none;
+    size_t chunkEnd = 0;
+    string_view schemaTag = span != nullptr ? span->schemaTag : string_view{};
+    uint64_t schemaKey = contentDefined && !schemaTag.empty() ? content_hash( schemaTag.data(), schemaTag.size() ) : 0;
+    uint64_t chunkKey = 0;
+    size_t stop = span != nullptr ? min( span->end, xml.size() ) : xml.size();
+
+    auto close_chunk = [&]() {
+        if ( chunkBegin != none ) {
+            entityChunks.push_back( {chunkBegin, chunkEnd, schemaTag, chunkKey} );
+            chunkBegin = none;
+        }
+    };
+
+    // In well-formed XML a '<' is always markup, so only those positions need a look --
+
+    size_t position = span != nullptr ? span->begin : 0;
+    while ( position < stop ) {
+        auto lt = static_cast<const char *>( memchr( xml.data() + position, '<', stop - position ) );
+        if ( lt == nullptr ) {
+            position = stop;
+            break;
+        }
+        position = static_cast<size_t>( lt - xml.data() );
+
+        if ( xml.compare( position, 4, "<!--" ) == 0 ) {
+            position = skip_past( xml, position + 4, "-->" );
+        } else if ( xml.compare( position, 9, "<![CDATA[" ) == 0 ) {
+            position = skip_past( xml, position + 9, "]]>" );
+        } else if ( xml.compare( position, 2, "<?" ) == 0 ) {
+            position = skip_past( xml, position + 2, "?>" );
+        } else if ( is_tag( xml, position, "<EntityType" ) ) {
+            size_t end = element_end( xml, position, "</EntityType" );
+            if ( chunkBegin == none ) {
+                chunkBegin = position;
+                chunkKey = schemaKey;
+            }
+            chunkEnd = end;
+            if ( contentDefined ) {
+
+                // A cut after one element in targetSize / size on average, plus a hard limit --
+
+                uint64_t elementKey = content_hash( xml.data() + position, end - position );
+                chunkKey = hash_combine( chunkKey, elementKey );
+                if ( elementKey % max<size_t>( 1, targetSize / ( end - position ) ) == 0 || chunkEnd - chunkBegin >= 8 * targetSize ) {
+                    close_chunk();
+                }
+            } else if ( chunkEnd - chunkBegin >= targetSize ) {
+                close_chunk();
+            }
+            position = end;
+        } else if ( is_tag( xml, position, "<EntityContainer" ) ) {
+            close_chunk();
+            size_t end = element_end( xml, position, "</EntityContainer" );
+            uint64_t key = contentDefined ? hash_combine( schemaKey, content_hash( xml.data() + position, end - position ) ) : 0;
+            containers.push_back( {position, end, schemaTag, key} );
+            position = end;
+        } else {
+            // A chunk must not span a Schema boundary, or it would not be well-formed --
+            if ( is_tag( xml, position, "<Schema" ) ) {
+                close_chunk();
+                size_t end = tag_end( xml, position );
+                schemaTag = xml.substr( position, end - position );
+                schemaKey = contentDefined ? content_hash( schemaTag.data(), schemaTag.size() ) : 0;
+                position = end;
+            } else {
+                if ( is_tag( xml, position, "</Schema" ) ) {
+                    close_chunk();
+                    schemaTag = {};
+                    schemaKey = 0;
+                }
+                ++position;
+            }
+        }
+    }
+    close_chunk();
+
+    if ( span != nullptr ) {
+        span->end = max( position, stop );
+        span->schemaTag = schemaTag;
+    }
+}
+
+bool ParallelReader::extract( string_view xml, const Range &range, Graph &graph, string &error ) {
+    XMLDocument doc;
+    doc.SetNameClassifier( classify_edm_name );
+    if ( doc.Parse( xml.data() + range.begin, range.end - range.begin ) != XML_SUCCESS ) {
+        error = "Parse error at byte " + to_string( range.begin ) + ": " + doc.ErrorStr();
+        return false;
+    }
+    if ( !range.schemaTag.empty() ) {
+        graph.begin_schema( attribute_value( range.schemaTag, EDMAttributeType::Namespace ), attribute_value( range.schemaTag, EDMAttributeType::Alias ) );
+    }
+    graph.visit( &doc );
+    return true;
+}
+
+bool ParallelReader::read( const char *fileName ) {
+    MappedFile file;
+    if ( !file.open( fileName ) ) {
+        errorText = "Couldn't open input file " + string{fileName};
+        return false;
+    }
+    totalRead = file.size();
+
+    auto xml = string_view{file.data(), file.size()};
+    vector<Range> entityChunks;
+    vector<Range> containers;
+    scan( xml, max<size_t>( 64 * 1024, xml.size() / ( threadCount * 8 ) ), entityChunks, containers );
+    chunks = entityChunks.size();
+
+    // Parse and extract the chunks --
+
+    vector<Graph> results( entityChunks.size() );
+    vector<string> errors( entityChunks.size() );
+
+    ThreadPool pool( threadCount );
+    pool.parallel_for( entityChunks.size(), [&]( size_t i ) { extract( xml, entityChunks[i], results[i], errors[i] ); } );
+
+    for ( const auto &error : errors ) {
+        if ( !error.empty() ) {
+            errorText = error;
+            return false;
+        }
+    }
+
+    for ( auto &result : results ) {
+        graph.merge( move( result ) );
+    }
+
+    // EntitySets last, once every association is known --
+
+    for ( const auto &container : containers ) {
+        Range sets = container;
+        sets.schemaTag = {};
+        if ( !extract( xml, sets, graph, errorText ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
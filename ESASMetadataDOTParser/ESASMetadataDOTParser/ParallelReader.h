@@ -0,0 +1,100 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef ParallelReader_h
+#define ParallelReader_h
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct Graph;
+
+/**
+ * Parallel reader for large, multi-Schema metadata.
+ *
+ * A pre-scan over the raw bytes finds every EntityType and EntityContainer
+ * element. Runs of EntityTypes that share a Schema are cut into chunks of
+ * about equal size. Each chunk is parsed by its own XMLDocument on a worker
+ * thread and extracted into its own Graph. The chunk graphs are then merged
+ * in document order, so the result is the same as a serial read.
+ */
+class ParallelReader {
+  public:
+    explicit ParallelReader( Graph &graph, unsigned threads = std::thread::hardware_concurrency() );
+
+    bool read( const char *fileName );
+
+    const std::string &error() const { return errorText; }
+    size_t bytesRead() const { return totalRead; }
+    size_t chunkCount() const { return chunks; }
+
+    struct Range {
+        size_t begin;
+        size_t end;
+        std::string_view schemaTag; // Start tag of the enclosing Schema
+        uint64_t key = 0;           // Hash of the Schema tag and the elements, with contentDefined
+    };
+
+    /**
+     * A stretch of xml for scan() to cover, in the Schema whose start tag is
+     * schemaTag. scan() leaves the tag in effect at the end in schemaTag and
+     * sets end past the last markup it read, if that runs on.
+     */
+    struct Span {
+        size_t begin = 0;
+        size_t end = std::string_view::npos;
+        std::string_view schemaTag;
+    };
+
+    /**
+     * Splits the EntityType elements in xml into well-formed chunks of about
+     * targetSize bytes each, and collects the EntityContainer elements.
+     *
+     * With contentDefined, chunks end after elements picked by the hash of
+     * their bytes instead of by size, so an edit moves no boundaries except
+     * around the edited element, and every range gets its key.
+     *
+     * With span, only that part of xml is scanned.
+     */
+    static void scan( std::string_view xml, size_t targetSize, std::vector<Range> &entityChunks, std::vector<Range> &containers,
+                      bool contentDefined = false, Span *span = nullptr );
+
+    /**
+     * Parses the elements in range of xml and extracts them into graph,
+     * under the Schema of the range.
+     */
+    static bool extract( std::string_view xml, const Range &range, Graph &graph, std::string &error );
+
+  private:
+    Graph &graph;
+    unsigned threadCount;
+    size_t totalRead = 0;
+    size_t chunks = 0;
+    std::string errorText;
+};
+
+#endif /* ParallelReader_h */
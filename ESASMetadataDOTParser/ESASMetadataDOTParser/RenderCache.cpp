@@ -0,0 +1,144 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "RenderCache.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace filesystem;
+
+namespace {
+
+constexpr auto EntryExtension = string_view{".dot"};
+
+} // namespace
+
+RenderCache::RenderCache( string directory, uint64_t maxBytes ) : directory( move( directory ) ), maxBytes( maxBytes ) {
+}
+
+uint64_t RenderCache::key( uint64_t inputHash, string_view centerEntity, string_view options ) {
+
+    // Lengths go in too, so no two argument lists run together the same way --
+
+    string material;
+    auto add = [&]( const void *data, size_t size ) { material.append( static_cast<const char *>( data ), size ); };
+    uint64_t centerLength = centerEntity.size();
+    uint64_t optionsLength = options.size();
+    add( &Version, sizeof( Version ) );
+    add( &inputHash, sizeof( inputHash ) );
+    add( &centerLength, sizeof( centerLength ) );
+    add( centerEntity.data(), centerEntity.size() );
+    add( &optionsLength, sizeof( optionsLength ) );
+    add( options.data(), options.size() );
+    return content_hash( material.data(), material.size() );
+}
+
+string RenderCache::entry_name( uint64_t key ) const {
+    char name[32];
+    snprintf( name, sizeof( name ), "%016llx%s", static_cast<unsigned long long>( key ), EntryExtension.data() );
+    return ( path( directory ) / name ).string();
+}
+
+bool RenderCache::fetch( uint64_t key, const string &outputFileName ) {
+    error_code error;
+    string entry = entry_name( key );
+    if ( !is_regular_file( entry, error ) ) {
+        return false;
+    }
+
+    // Replace rather than overwrite the output, it may be a link to another entry --
+
+    remove( outputFileName, error );
+    create_hard_link( entry, outputFileName, error );
+    if ( error ) {
+        error.clear();
+        copy_file( entry, outputFileName, copy_options::overwrite_existing, error );
+        if ( error ) {
+            errorText = "couldn't copy " + entry + " to " + outputFileName + ": " + error.message();
+            return false;
+        }
+    }
+
+    // Mark the entry as recently used --
+
+    last_write_time( entry, file_time_type::clock::now(), error );
+    return true;
+}
+
+/**
+ * Copies to a temporary name and renames it into place, so a concurrent
+ * fetch never sees half an entry.
+ */
+bool RenderCache::store( uint64_t key, const string &outputFileName ) {
+    error_code error;
+    create_directories( directory, error );
+
+    string entry = entry_name( key );
+    string temporary = entry + ".tmp";
+    copy_file( outputFileName, temporary, copy_options::overwrite_existing, error );
+    if ( !error ) {
+        rename( temporary, entry, error );
+    }
+    if ( error ) {
+        errorText = "couldn't add " + outputFileName + " to " + directory + ": " + error.message();
+        remove( temporary, error );
+        return false;
+    }
+
+    evict();
+    return true;
+}
+
+void RenderCache::evict() {
+    error_code error;
+    vector<pair<file_time_type, path>> entries;
+    uint64_t total = 0;
+    for ( const auto &item : directory_iterator( directory, error ) ) {
+        if ( item.path().extension() != EntryExtension || !item.is_regular_file( error ) ) {
+            continue;
+        }
+        total += item.file_size( error );
+        entries.emplace_back( item.last_write_time( error ), item.path() );
+    }
+    if ( total <= maxBytes ) {
+        return;
+    }
+
+    sort( entries.begin(), entries.end() );
+    for ( const auto &entry : entries ) {
+        if ( total <= maxBytes ) {
+            break;
+        }
+        uint64_t size = file_size( entry.second, error );
+        if ( !error && remove( entry.second, error ) ) {
+            total -= size;
+        }
+    }
+}
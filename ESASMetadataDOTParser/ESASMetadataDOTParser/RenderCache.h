@@ -0,0 +1,76 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef RenderCache_h
+#define RenderCache_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * On-disk cache of finished DOT files.
+ *
+ * An entry is named after a key over everything the output depends on: the
+ * content hash of the metadata, the center entity and the rendering
+ * options. A hit is handed out as a hard link to the entry, or as a copy
+ * where links are not possible. Entries are kept least recently used first
+ * within a size limit.
+ */
+class RenderCache {
+  public:
+    static constexpr uint32_t Version = 1; // Bump on any change to the DOT output
+
+    RenderCache( std::string directory, uint64_t maxBytes );
+
+    /**
+     * Key of the output for the metadata with inputHash, rendered around
+     * centerEntity ("" for the whole diagram) with options, which must
+     * spell out every other setting that changes the output.
+     */
+    static uint64_t key( uint64_t inputHash, std::string_view centerEntity, std::string_view options );
+
+    /**
+     * Puts the entry for key at outputFileName. False on a miss.
+     */
+    bool fetch( uint64_t key, const std::string &outputFileName );
+
+    /**
+     * Adds outputFileName as the entry for key, then evicts the least
+     * recently used entries until the cache fits its size limit again.
+     */
+    bool store( uint64_t key, const std::string &outputFileName );
+
+    const std::string &error() const { return errorText; }
+
+  private:
+    std::string entry_name( uint64_t key ) const;
+    void evict();
+
+    std::string directory;
+    uint64_t maxBytes;
+    std::string errorText;
+};
+
+#endif /* RenderCache_h */
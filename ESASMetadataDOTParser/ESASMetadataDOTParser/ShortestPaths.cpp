@@ -0,0 +1,212 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "ShortestPaths.h"
+#include <algorithm>
+
+using namespace std;
+
+ShortestPaths::ShortestPaths( const Adjacency &graph, Adjacency::Direction direction ) : graph( graph ), direction( direction ) {
+}
+
+/**
+ * Calls f( edge, node ) for every edge that can be taken from node, with
+ * the node it leads to. Forward follows direction from the start of a
+ * path, backward follows it in reverse from the end.
+ */
+template <typename F>
+void ShortestPaths::for_each_step( Adjacency::Node node, bool forward, F f ) const {
+    bool out = direction == Adjacency::Direction::Both || ( direction == Adjacency::Direction::Out ) == forward;
+    bool in = direction == Adjacency::Direction::Both || ( direction == Adjacency::Direction::In ) == forward;
+    if ( out ) {
+        for ( uint32_t edge : graph.out( node ) ) {
+            f( edge, graph.target( edge ) );
+        }
+    }
+    if ( in ) {
+        for ( uint32_t edge : graph.in( node ) ) {
+            f( edge, graph.source( edge ) );
+        }
+    }
+}
+
+bool ShortestPaths::search( Adjacency::Node start, Adjacency::Node end ) {
+    from = start;
+    to = end;
+    pathLength = None;
+    pathNodes = Adjacency::Bits( graph.node_count() );
+    pathEdges = Adjacency::Bits( graph.edge_count() );
+    levels.assign( graph.node_count(), None );
+    if ( from == Adjacency::None || to == Adjacency::None ) {
+        return false;
+    }
+    if ( from == to ) {
+        pathLength = 0;
+        levels[from] = 0;
+        pathNodes.set( from );
+        return true;
+    }
+
+    // Distances from the start and to the end, each side grown a level at a time --
+
+    vector<uint32_t> distance[2] = {vector<uint32_t>( graph.node_count(), None ), vector<uint32_t>( graph.node_count(), None )};
+    vector<Adjacency::Node> frontier[2] = {{from}, {to}};
+    uint32_t depth[2] = {0, 0};
+    distance[0][from] = 0;
+    distance[1][to] = 0;
+
+    vector<Adjacency::Node> meeting;
+    vector<Adjacency::Node> next;
+    while ( meeting.empty() && !frontier[0].empty() && !frontier[1].empty() ) {
+        int side = frontier[0].size() <= frontier[1].size() ? 0 : 1;
+        auto &mine = distance[side];
+        const auto &theirs = distance[1 - side];
+        uint32_t level = ++depth[side];
+
+        next.clear();
+        for ( auto node : frontier[side] ) {
+            for_each_step( node, side == 0, [&]( uint32_t, Adjacency::Node reached ) {
+                if ( mine[reached] == None ) {
+                    mine[reached] = level;
+                    next.push_back( reached );
+                    if ( theirs[reached] != None ) {
+                        meeting.push_back( reached );
+                    }
+                }
+            } );
+        }
+        frontier[side].swap( next );
+    }
+    if ( meeting.empty() ) {
+        return false;
+    }
+
+    // Nothing met before this level, so every meeting node is exactly depth[1 - side] from the other end --
+
+    pathLength = depth[0] + depth[1];
+    for ( auto node : meeting ) {
+        pathNodes.set( node );
+        levels[node] = distance[0][node];
+    }
+
+    // Back towards the start on the start side, on towards the end on the other --
+
+    for ( int side = 0; side < 2; ++side ) {
+        vector<Adjacency::Node> layer = meeting;
+        while ( !layer.empty() ) {
+            next.clear();
+            for ( auto node : layer ) {
+                uint32_t here = distance[side][node];
+                if ( here == 0 || here == None ) {
+                    continue;
+                }
+                for_each_step( node, side == 1, [&]( uint32_t edge, Adjacency::Node reached ) {
+                    if ( distance[side][reached] != here - 1 ) {
+                        return;
+                    }
+                    pathEdges.set( edge );
+                    if ( !pathNodes.test( reached ) ) {
+                        pathNodes.set( reached );
+                        levels[reached] = side == 0 ? here - 1 : pathLength - ( here - 1 );
+                        next.push_back( reached );
+                    }
+                } );
+            }
+            layer.swap( next );
+        }
+    }
+    return true;
+}
+
+uint64_t ShortestPaths::count() const {
+    if ( pathLength == None ) {
+        return 0;
+    }
+
+    // Paths into each node, level by level --
+
+    vector<Adjacency::Node> order;
+    pathNodes.for_each( [&]( Adjacency::Node node ) { order.push_back( node ); } );
+    sort( order.begin(), order.end(), [&]( Adjacency::Node a, Adjacency::Node b ) { return levels[a] < levels[b]; } );
+
+    vector<uint64_t> ways( graph.node_count(), 0 );
+    ways[from] = 1;
+    for ( auto node : order ) {
+        for_each_step( node, true, [&]( uint32_t edge, Adjacency::Node reached ) {
+            if ( pathEdges.test( edge ) && levels[reached] == levels[node] + 1 ) {
+                ways[reached] = ways[node] > UINT64_MAX - ways[reached] ? UINT64_MAX : ways[reached] + ways[node];
+            }
+        } );
+    }
+    return ways[to];
+}
+
+vector<vector<uint32_t>> ShortestPaths::enumerate( size_t limit ) const {
+    vector<vector<uint32_t>> paths;
+    if ( pathLength == None || limit == 0 ) {
+        return paths;
+    }
+    if ( pathLength == 0 ) {
+        paths.emplace_back();
+        return paths;
+    }
+
+    // One frame per node on the current path: the steps onward and the next one to try --
+
+    struct Frame {
+        vector<pair<uint32_t, Adjacency::Node>> steps;
+        size_t next = 0;
+    };
+    auto frame_of = [&]( Adjacency::Node node ) {
+        Frame frame;
+        for_each_step( node, true, [&]( uint32_t edge, Adjacency::Node reached ) {
+            if ( pathEdges.test( edge ) && levels[reached] == levels[node] + 1 ) {
+                frame.steps.emplace_back( edge, reached );
+            }
+        } );
+        return frame;
+    };
+
+    vector<Frame> stack{frame_of( from )};
+    vector<uint32_t> path;
+    while ( !stack.empty() && paths.size() < limit ) {
+        auto &frame = stack.back();
+        if ( frame.next == frame.steps.size() ) {
+            stack.pop_back();
+            if ( !path.empty() ) {
+                path.pop_back();
+            }
+            continue;
+        }
+        auto step = frame.steps[frame.next++];
+        path.push_back( step.first );
+        if ( step.second == to ) {
+            paths.push_back( path );
+            path.pop_back();
+        } else {
+            stack.push_back( frame_of( step.second ) );
+        }
+    }
+    return paths;
+}
@@ -0,0 +1,90 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef ShortestPaths_h
+#define ShortestPaths_h
+
+#include "Adjacency.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * All shortest paths between two nodes of an Adjacency, for --path.
+ *
+ * A bidirectional breadth first search grows one level at a time from
+ * whichever side has the smaller frontier, until the sides meet after a
+ * full level. Every shortest path then crosses the meeting level, so the
+ * nodes and edges on all of them are found by walking back from the
+ * meeting nodes towards either end, along edges that lose one level per
+ * step. Nothing beyond the two searched balls is visited.
+ */
+class ShortestPaths {
+  public:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    ShortestPaths( const Adjacency &graph, Adjacency::Direction direction = Adjacency::Direction::Both );
+
+    /**
+     * False if to cannot be reached from from.
+     */
+    bool search( Adjacency::Node from, Adjacency::Node to );
+
+    uint32_t length() const { return pathLength; } // In edges
+    const Adjacency::Bits &nodes() const { return pathNodes; }
+    const Adjacency::Bits &edges() const { return pathEdges; }
+
+    /**
+     * Number of shortest paths, UINT64_MAX if there are more.
+     */
+    uint64_t count() const;
+
+    /**
+     * The first limit shortest paths, each as its edges from from to to.
+     * Depth first without recursion; costs limit times the path length.
+     */
+    std::vector<std::vector<uint32_t>> enumerate( size_t limit ) const;
+
+    /**
+     * The node at the other end of edge, seen from node.
+     */
+    Adjacency::Node across( uint32_t edge, Adjacency::Node node ) const {
+        return graph.source( edge ) == node ? graph.target( edge ) : graph.source( edge );
+    }
+
+  private:
+    template <typename F>
+    void for_each_step( Adjacency::Node node, bool forward, F f ) const;
+
+    const Adjacency &graph;
+    Adjacency::Direction direction;
+    Adjacency::Node from = Adjacency::None;
+    Adjacency::Node to = Adjacency::None;
+    uint32_t pathLength = None;
+    std::vector<uint32_t> levels; // Distance from from, for the nodes on the paths
+    Adjacency::Bits pathNodes;
+    Adjacency::Bits pathEdges;
+};
+
+#endif /* ShortestPaths_h */
@@ -0,0 +1,114 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "Stats.h"
+#include <algorithm>
+#include <iomanip>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+void Stats::record( const string &name, double seconds ) {
+    if ( find( phases.begin(), phases.end(), name ) == phases.end() ) {
+        phases.push_back( name );
+    }
+    session.store_one_time( name, seconds );
+}
+
+void Stats::count( const string &name, size_t value ) {
+    for ( auto &[key, current] : counters ) {
+        if ( key == name ) {
+            current = value;
+            return;
+        }
+    }
+    counters.emplace_back( name, value );
+}
+
+void Stats::print( ostream &stream ) const {
+    auto reports = session.report_list();
+
+    size_t width = 0;
+    for ( const auto &name : phases ) {
+        width = max( width, name.size() );
+    }
+    for ( const auto &[name, value] : counters ) {
+        width = max( width, name.size() );
+    }
+
+    double total = 0;
+    stream << "Phases:" << endl;
+    for ( const auto &name : phases ) {
+        const auto &report = reports[name];
+        total += report.total_time;
+        stream << "  " << left << setw( static_cast<int>( width ) ) << name << right << setw( 12 ) << fixed << setprecision( 3 )
+               << report.total_time * 1000 << " ms";
+        if ( report.nb_calls > 1 ) {
+            stream << "  (" << report.nb_calls << " runs)";
+        }
+        stream << endl;
+    }
+    stream << "  " << left << setw( static_cast<int>( width ) ) << "total" << right << setw( 12 ) << total * 1000 << " ms" << endl;
+
+    stream << "Counters:" << endl;
+    for ( const auto &[name, value] : counters ) {
+        stream << "  " << left << setw( static_cast<int>( width ) ) << name << right << setw( 12 ) << value << endl;
+    }
+    stream << "  " << left << setw( static_cast<int>( width ) ) << "peak_rss_bytes" << right << setw( 12 ) << peak_rss() << endl;
+}
+
+void Stats::print_json( ostream &stream ) const {
+    auto reports = session.report_list();
+
+    // Phase and counter names are plain identifiers, no escaping needed --
+
+    stream << "{\n  \"phases\": {";
+    for ( size_t i = 0; i < phases.size(); ++i ) {
+        stream << ( i == 0 ? "\n" : ",\n" ) << "    \"" << phases[i] << "\": " << fixed << setprecision( 6 ) << reports[phases[i]].total_time;
+    }
+    stream << "\n  },\n  \"counters\": {";
+    for ( size_t i = 0; i < counters.size(); ++i ) {
+        stream << ( i == 0 ? "\n" : ",\n" ) << "    \"" << counters[i].first << "\": " << counters[i].second;
+    }
+    stream << ( counters.empty() ? "" : "," ) << "\n    \"peak_rss_bytes\": " << peak_rss() << "\n  }\n}" << endl;
+}
+
+size_t Stats::peak_rss() {
+#if defined( __unix__ ) || defined( __APPLE__ )
+    rusage usage{};
+    if ( getrusage( RUSAGE_SELF, &usage ) != 0 ) {
+        return 0;
+    }
+#if defined( __APPLE__ )
+    return static_cast<size_t>( usage.ru_maxrss ); // Bytes on macOS
+#else
+    return static_cast<size_t>( usage.ru_maxrss ) * 1024; // Kilobytes on Linux
+#endif
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,77 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef Stats_h
+#define Stats_h
+
+#include <fplus/fplus.hpp>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Measurements for --stats: wall time per phase, recorded in an
+ * fplus::benchmark_session, plus named counters. Phases and counters are
+ * reported in the order they were first recorded.
+ */
+class Stats {
+  public:
+    /**
+     * Times the enclosing scope as one run of the named phase.
+     */
+    class Phase {
+      public:
+        Phase( Stats &stats, std::string name ) : stats( stats ), name( std::move( name ) ) {}
+        ~Phase() { stats.record( name, timer.elapsed() ); }
+
+        Phase( const Phase & ) = delete;
+        Phase &operator=( const Phase & ) = delete;
+
+      private:
+        Stats &stats;
+        std::string name;
+        fplus::stopwatch timer;
+    };
+
+    Phase phase( std::string name ) { return Phase( *this, std::move( name ) ); }
+    void record( const std::string &name, double seconds );
+    void count( const std::string &name, size_t value );
+
+    void print( std::ostream &stream ) const;
+    void print_json( std::ostream &stream ) const;
+
+    /**
+     * Peak resident set size of the process in bytes, 0 where unknown.
+     */
+    static size_t peak_rss();
+
+  private:
+    fplus::benchmark_session session;
+    std::vector<std::string> phases;
+    std::vector<std::pair<std::string, size_t>> counters;
+};
+
+#endif /* Stats_h */
@@ -0,0 +1,147 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "StringTable.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t BlockSize = 64 * 1024;
+
+} // namespace
+
+StringTable::StringTable() : slots( 1024, 0 ) {
+}
+
+StringTable::Id StringTable::intern( string_view text ) {
+    uint32_t hashValue = hash( text );
+    size_t slot = slot_of( text, hashValue );
+    if ( slots[slot] != 0 ) {
+        return slots[slot] - 1;
+    }
+
+    Id id = static_cast<Id>( size() );
+    entries.push_back( store( text ) );
+    slots[slot] = id + 1;
+
+    // Keep the load factor below one half --
+
+    if ( size() * 2 > slots.size() ) {
+        grow();
+    }
+    return id;
+}
+
+StringTable::Id StringTable::find( string_view text ) const {
+    Id entry = slots[slot_of( text, hash( text ) )];
+    return entry != 0 ? entry - 1 : None;
+}
+
+void StringTable::borrow( const char *begin, size_t length, shared_ptr<const void> owner ) {
+    borrowed.push_back( {begin, begin + length, move( owner )} );
+}
+
+void StringTable::restore( const char *characters, const uint32_t *ends, size_t count, vector<Id> hashSlots, shared_ptr<const void> owner ) {
+    entries.clear();
+    entries.reserve( count );
+    for ( size_t id = 0, begin = 0; id < count; begin = ends[id++] ) {
+        entries.emplace_back( characters + begin, ends[id] - begin );
+    }
+    slots = move( hashSlots );
+    borrow( characters, count > 0 ? ends[count - 1] : 0, move( owner ) );
+}
+
+size_t StringTable::memoryUsage() const {
+    return blockBytes + entries.capacity() * sizeof( string_view ) + slots.capacity() * sizeof( Id );
+}
+
+/**
+ * Returns a view of text that lives as long as the table: text itself when
+ * it lies in a borrowed buffer, otherwise a copy in the current block.
+ */
+string_view StringTable::store( string_view text ) {
+    for ( const auto &buffer : borrowed ) {
+        if ( text.data() >= buffer.begin && text.data() + text.size() <= buffer.end ) {
+            return text;
+        }
+    }
+    if ( text.empty() ) {
+        return {};
+    }
+
+    if ( text.size() > blockFree ) {
+        size_t size = max( BlockSize, text.size() );
+        blocks.emplace_back( new char[size] );
+        blockNext = blocks.back().get();
+        blockFree = size;
+        blockBytes += size;
+    }
+
+    string_view copy{blockNext, text.size()};
+    memcpy( blockNext, text.data(), text.size() );
+    blockNext += text.size();
+    blockFree -= text.size();
+    copied += text.size();
+    return copy;
+}
+
+/**
+ * FNV-1a, which is plenty for identifiers.
+ */
+uint32_t StringTable::hash( string_view text ) {
+    uint32_t value = 2166136261u;
+    for ( unsigned char c : text ) {
+        value = ( value ^ c ) * 16777619u;
+    }
+    return value;
+}
+
+/**
+ * Returns the slot holding text, or the empty slot where it belongs.
+ */
+size_t StringTable::slot_of( string_view text, uint32_t hashValue ) const {
+    size_t mask = slots.size() - 1;
+    for ( size_t slot = hashValue & mask;; slot = ( slot + 1 ) & mask ) {
+        Id entry = slots[slot];
+        if ( entry == 0 || ( *this )[entry - 1] == text ) {
+            return slot;
+        }
+    }
+}
+
+void StringTable::grow() {
+    vector<Id> old( slots.size() * 2, 0 );
+    old.swap( slots );
+    size_t mask = slots.size() - 1;
+    for ( Id id = 0; id < size(); ++id ) {
+        size_t slot = hash( ( *this )[id] ) & mask;
+        while ( slots[slot] != 0 ) {
+            slot = ( slot + 1 ) & mask;
+        }
+        slots[slot] = id + 1;
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef StringTable_h
+#define StringTable_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * Interns strings into dense 32 bit ids. Every distinct string is stored
+ * once, in fixed blocks that never move, and the hash index only holds ids.
+ *
+ * Text that lies inside a buffer registered with borrow() is not copied at
+ * all; the table keeps a view into the buffer and holds on to its owner.
+ */
+class StringTable {
+  public:
+    typedef uint32_t Id;
+    static constexpr Id None = UINT32_MAX;
+
+    StringTable();
+
+    Id intern( std::string_view text );
+    Id find( std::string_view text ) const;
+
+    /**
+     * Strings interned from inside [begin, begin + length) from now on are
+     * kept as views into that buffer. owner is held until the table is
+     * destroyed and must keep the buffer alive and unchanged until then.
+     */
+    void borrow( const char *begin, size_t length, std::shared_ptr<const void> owner );
+
+    std::string_view operator[]( Id id ) const { return entries[id]; }
+
+    /**
+     * Snapshot support: the hash slots, and restoring a table from the
+     * strings in id order back to back in characters, ends[i] being the end
+     * offset of string i, plus the saved slots. The characters are borrowed
+     * from owner as with borrow().
+     */
+    const std::vector<Id> &hash_slots() const { return slots; }
+    void restore( const char *characters, const uint32_t *ends, size_t count, std::vector<Id> hashSlots, std::shared_ptr<const void> owner );
+
+    size_t size() const { return entries.size(); }
+    size_t memoryUsage() const;
+    size_t copiedBytes() const { return copied; } // Characters stored by the table itself
+
+  private:
+    static uint32_t hash( std::string_view text );
+    size_t slot_of( std::string_view text, uint32_t hashValue ) const;
+    void grow();
+    std::string_view store( std::string_view text );
+
+    struct Borrowed {
+        const char *begin;
+        const char *end;
+        std::shared_ptr<const void> owner;
+    };
+
+    std::vector<std::string_view> entries;       // Indexed by id
+    std::vector<Id> slots;                       // Open addressing, id + 1 or 0 for an empty slot
+    std::vector<std::unique_ptr<char[]>> blocks; // Characters of the strings that were copied
+    char *blockNext = nullptr;                   // Unused characters at the end of the last block
+    size_t blockFree = 0;
+    size_t blockBytes = 0;
+    size_t copied = 0;
+    std::vector<Borrowed> borrowed;
+};
+
+#endif /* StringTable_h */
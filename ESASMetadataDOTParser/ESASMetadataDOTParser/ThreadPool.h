@@ -0,0 +1,181 @@
+/*
+ Original code by Castle+Andersen ApS (castleandersen.dk)
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any
+ damages arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any
+ purpose, including commercial applications, and to alter it and
+ redistribute it freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must
+ not claim that you wrote the original software. If you use this
+ software in a product, an acknowledgment in the product documentation
+ would be appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and
+ must not be misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fork/join pool with persistent workers and work stealing. The items of a
+ * job are split into one contiguous range per thread. Every thread takes
+ * items from the front of its own range, and once that is empty steals the
+ * back half of the fullest other one, so uneven items balance out without
+ * a shared counter. The workers sleep between jobs and are started once
+ * per pool, not once per job.
+ *
+ * start() hands a job to the workers and returns, so the caller can do
+ * other work meanwhile; wait() then helps with the rest and returns once
+ * the job is done. parallel_for() does both.
+ */
+class ThreadPool {
+  public:
+    explicit ThreadPool( unsigned threads = std::thread::hardware_concurrency() ) : count( std::max( 1u, threads ) ), ranges( count ) {
+        for ( unsigned slot = 1; slot < count; ++slot ) {
+            workers.emplace_back( [this, slot]() { work( slot ); } );
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            stopping = true;
+        }
+        wake.notify_all();
+        for ( auto &worker : workers ) {
+            worker.join();
+        }
+    }
+
+    ThreadPool( const ThreadPool & ) = delete;
+    ThreadPool &operator=( const ThreadPool & ) = delete;
+
+    unsigned size() const { return count; }
+
+    template <typename Function>
+    void parallel_for( size_t items, Function &&function ) {
+        start( items, function );
+        wait();
+    }
+
+    /**
+     * Runs function( i ) for every i < items on the workers. items must be
+     * below 2^32, and function must stay alive until wait().
+     */
+    template <typename Function>
+    void start( size_t items, Function &function ) {
+        job = &function;
+        invoke = []( void *target, size_t item ) { ( *static_cast<Function *>( target ) )( item ); };
+        for ( size_t slot = 0; slot < count; ++slot ) {
+            ranges[slot].store( pack( items * slot / count, items * ( slot + 1 ) / count ) );
+        }
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            busy = count - 1;
+            ++generation;
+        }
+        wake.notify_all();
+    }
+
+    void wait() {
+        run( 0 );
+        std::unique_lock<std::mutex> lock( mutex );
+        done.wait( lock, [this]() { return busy == 0; } );
+    }
+
+  private:
+    // A range of items as begin << 32 | end --
+    static uint64_t pack( uint64_t begin, uint64_t end ) { return begin << 32 | end; }
+    static uint64_t begin_of( uint64_t range ) { return range >> 32; }
+    static uint64_t end_of( uint64_t range ) { return range & 0xFFFFFFFF; }
+    static uint64_t left_in( uint64_t range ) { return begin_of( range ) < end_of( range ) ? end_of( range ) - begin_of( range ) : 0; }
+
+    void run( unsigned slot ) {
+        do {
+            uint64_t range = ranges[slot].load();
+            while ( left_in( range ) > 0 ) {
+                if ( ranges[slot].compare_exchange_weak( range, pack( begin_of( range ) + 1, end_of( range ) ) ) ) {
+                    invoke( job, begin_of( range ) );
+                    range = ranges[slot].load();
+                }
+            }
+        } while ( steal( slot ) );
+    }
+
+    // Moves the back half of the fullest other range into the empty own one; false once all are empty --
+    bool steal( unsigned slot ) {
+        for ( ;; ) {
+            unsigned victim = slot;
+            uint64_t seen = 0;
+            for ( unsigned other = 0; other < count; ++other ) {
+                uint64_t range = ranges[other].load();
+                if ( other != slot && left_in( range ) > left_in( seen ) ) {
+                    victim = other;
+                    seen = range;
+                }
+            }
+            if ( victim == slot ) {
+                return false;
+            }
+            uint64_t middle = end_of( seen ) - ( left_in( seen ) + 1 ) / 2;
+            if ( ranges[victim].compare_exchange_strong( seen, pack( begin_of( seen ), middle ) ) ) {
+                ranges[slot].store( pack( middle, end_of( seen ) ) );
+                return true;
+            }
+        }
+    }
+
+    void work( unsigned slot ) {
+        uint64_t seen = 0;
+        for ( ;; ) {
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                wake.wait( lock, [&]() { return stopping || generation != seen; } );
+                if ( stopping ) {
+                    return;
+                }
+                seen = generation;
+            }
+            run( slot );
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                if ( --busy == 0 ) {
+                    done.notify_one();
+                }
+            }
+        }
+    }
+
+    unsigned count;
+    std::vector<std::atomic<uint64_t>> ranges; // Per thread, the caller's first
+    std::vector<std::thread> workers;
+    void *job = nullptr;
+    void ( *invoke )( void *, size_t ) = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    unsigned busy = 0;
+    bool stopping = false;
+};
+
+#endif /* ThreadPool_h */
@@ -21,303 +21,632 @@
  distribution.
  */
 
+#include "CSDLReader.h"
+#include "EDM.h"
+#include "FileWatcher.h"
+#include "Graph.h"
+#include "IncrementalReader.h"
+#include "IncrementalWriter.h"
+#include "MappedFile.h"
+#include "ModelDiff.h"
+#include "ContentHash.h"
+#include "ModelSnapshot.h"
+#include "ParallelReader.h"
+#include "RenderCache.h"
+#include "ShortestPaths.h"
+#include "Stats.h"
 #include "tinyxml2.h"
 #include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <map>
 #include <memory>
-#include <regex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 using namespace std;
 using namespace filesystem;
 using namespace tinyxml2;
 
-/**
- * ALL THE BASIC EDM PROPERTIES
- */
-
-struct EDMPropertyType {
-    static constexpr auto Edmx = string_view{"edmx:Edmx"};
-    static constexpr auto DataServices = string_view{"edmx:DataServices"};
-    static constexpr auto Schema = string_view{"Schema"};
-    static constexpr auto ComplexType = string_view{"ComplexType"};
-    static constexpr auto Property = string_view{"Property"};
-    static constexpr auto PropertyRef = string_view{"PropertyRef"};
-    static constexpr auto Key = string_view{"Key"};
-    static constexpr auto NavigationProperty = string_view{"NavigationProperty"};
-    static constexpr auto EntityType = string_view{"EntityType"};
-    static constexpr auto ReferentialConstraint = string_view{"ReferentialConstraint"};
-    static constexpr auto EntitySet = string_view{"EntitySet"};
-    static constexpr auto EntityContainer = string_view{"EntityContainer"};
-};
-
-/**
- * ALL THE BASIC EDM ATTRIBUTES
- */
-struct EDMAttributeType {
-    static constexpr auto Name = string_view{"Name"};
-    static constexpr auto Type = string_view{"Type"};
-    static constexpr auto Nullable = string_view{"Nullable"};
-    static constexpr auto ContainsTarget = string_view{"ContainsTarget"};
-    static constexpr auto ReferencedProperty = string_view{"ReferencedProperty"};
-    static constexpr auto EntityType = string_view{"EntityType"};
-    static constexpr auto Property = string_view{"Property"};
-    static constexpr auto Version = string_view{"Version"};
-    static constexpr auto Namespace = string_view{"Namespace"};
-};
-
-/**
- * Typedefs
- */
-typedef map<string, string> Properties;
-typedef vector<string> Strings;
-typedef std::map<string, vector<string>> Associations;
-
 /**
  * Helpers
  */
 
-template <typename... Args>
-void append_to_string( string &str, Args... args ) {
-    ( str.append( args ), ... );
-}
-
 template <typename... Args>
 void log( Args... args ) {
     ( ( cout << args ), ... );
 }
 
-struct Graph {
+void print_done( string_view dotFileName ) {
+    cout << "Now use GraphViz to generate the diagram using fdp, dot, neato or equivalent:" << endl
+         << endl;
+    cout << "   /usr/local/bin/dot  -Tpdf " << dotFileName << "  -o /tmp/ER.pdf && open /tmp/ER.pdf" << endl
+         << endl;
+    cout << "Done." << endl;
+}
 
-    void add_entity( const string &name, const string &type ) {
-        for ( auto &[key, value] : associations ) {
-            for ( auto &i : value ) {
-                if ( i == type ) {
-                    i = name;
-                }
+/**
+ * The output may be a hard link into the render cache; writing through it
+ * would change the cache entry, so it is replaced instead.
+ */
+void unlink_shared_output( string_view dotFileName ) {
+    error_code error;
+    if ( hard_link_count( path( dotFileName ), error ) > 1 && !error ) {
+        remove( path( dotFileName ), error );
+    }
+}
+
+/**
+ * --diff: compares the model of an older version of the metadata with the
+ * current one and renders what changed.
+ */
+int diff( string_view beforeFileName, string_view xmlFileName, string_view dotFileName, string_view diffJsonFileName, unsigned threads,
+          Stats &measurements ) {
+    Graph before;
+    Graph after;
+    {
+        auto timer = measurements.phase( "read" );
+        for ( auto [fileName, graph] : {make_pair( beforeFileName, &before ), make_pair( xmlFileName, &after )} ) {
+            ParallelReader reader( *graph, threads );
+            if ( !reader.read( fileName.data() ) ) {
+                cout << "Couldn't read input file " << path( fileName ).native() << ": " << reader.error() << endl;
+                return 1;
             }
         }
     }
+    {
+        auto timer = measurements.phase( "resolve" );
+        before.resolve();
+        after.resolve();
+    }
 
-    void add_table( const string &name, const map<string, string> &propterties ) {
-
-        constexpr auto &border = "\'1\'";
-        constexpr auto &cellBorder = "\'1\'";
-        constexpr auto &color = "\'aliceblue\'";
-        constexpr auto &bgcolor = "\'lightskyblue\'";
-        constexpr auto &colSpan = "\'2'";
+    ModelDiff changes( before.model(), after.model() );
+    {
+        auto timer = measurements.phase( "diff" );
+        changes.compare();
+    }
+    cout << changes.count( ModelDiff::Change::Added ) << " entities added, " << changes.count( ModelDiff::Change::Removed ) << " removed, "
+         << changes.count( ModelDiff::Change::Changed ) << " changed; " << changes.properties().size() << " property and "
+         << changes.edges().size() << " edge changes" << endl;
+    measurements.count( "property_changes", changes.properties().size() );
+    measurements.count( "edge_changes", changes.edges().size() );
+
+    if ( !diffJsonFileName.empty() ) {
+        ofstream json( diffJsonFileName.data() );
+        changes.print_json( json );
+    }
 
-        auto newTable = string{};
-        append_to_string( newTable, name,
+    unlink_shared_output( dotFileName );
+    ofstream myfile( dotFileName.data() );
+    if ( !myfile.is_open() ) {
+        cout << "Error writing to file!" << endl;
+        return 1;
+    }
+    {
+        auto timer = measurements.phase( "print" );
+        changes.print_graph( myfile );
+    }
+    myfile.close();
+    print_done( dotFileName );
+    return 0;
+}
 
-                          " [\n rankdir=LR shape=plaintext\n label=<",
-                          "<table border=", border,
-                          " bgcolor=", bgcolor,
-                          " cellborder=", cellBorder,
-                          " color=", color,
-                          ">",
-                          " <tr><td colspan=", colSpan, ">", name, "</td></tr>" );
+/**
+ * --path: keeps the entities and edges on the shortest paths from source to
+ * target and prints the first of them. With a limit only those are kept.
+ * False, and the graph left as it is, if source or target is not an entity.
+ */
+bool keep_paths( Graph &graph, const string &source, const string &target, Adjacency::Direction direction, size_t limit ) {
+    const auto &model = graph.model();
+    const auto &index = graph.adjacency();
+    for ( const auto &name : {source, target} ) {
+        if ( index.node( model.strings.find( name ) ) == Adjacency::None ) {
+            cout << "Unknown entity " << name << " in --path" << endl;
+            return false;
+        }
+    }
 
-        if ( !propterties.empty() ) {
-            for ( const auto &[value, key] : propterties ) {
+    ShortestPaths paths( index, direction );
+    if ( !paths.search( index.node( model.strings.find( source ) ), index.node( model.strings.find( target ) ) ) ) {
+        cout << "No path from " << source << " to " << target << endl;
+        graph.keep( paths.nodes(), paths.edges() );
+        return true;
+    }
 
-                append_to_string( newTable, "\n<tr><td PORT=\"", value, "\" ALIGN=\"LEFT\">", value, "</td><td ALIGN=\"LEFT\">", key, "</td></tr>" );
-            }
+    auto listed = paths.enumerate( limit > 0 ? limit : 10 );
+    auto count = paths.count();
+    cout << ( count == UINT64_MAX ? string{"More than "} + to_string( count - 1 ) : to_string( count ) ) << " shortest path(s) of "
+         << paths.length() << " edge(s) from " << source << " to " << target << endl;
+
+    Adjacency::Bits nodes( index.node_count() );
+    Adjacency::Bits edges( index.edge_count() );
+    for ( const auto &path : listed ) {
+        auto node = index.node( model.strings.find( source ) );
+        nodes.set( node );
+        cout << "   " << source;
+        for ( uint32_t edge : path ) {
+            auto field = model.strings[model.edgeSourceFields[edge]];
+            bool forward = index.source( edge ) == node;
+            node = paths.across( edge, node );
+            nodes.set( node );
+            edges.set( edge );
+            cout << ( forward ? " -" : " <-" ) << field << ( forward ? "-> " : "- " ) << model.strings[index.name( node )];
         }
-        append_to_string( newTable, " </table>\n>]", " [fillcolor=aliceblue style=filled fontname=Helvetica];\n" );
-        elements.emplace_back( newTable );
+        cout << endl;
+    }
+
+    if ( limit > 0 ) {
+        graph.keep( nodes, edges );
+    } else {
+        graph.keep( paths.nodes(), paths.edges() );
     }
+    return true;
+}
 
-    void create_arrows() {
-        string newNode;
-        for ( auto const &[key, value] : associations ) {
-            for ( auto const &element : value ) {
+/**
+ * --watch: renders, then renders again after every change to the metadata.
+ * Only the parts of the metadata that changed are parsed, resolved and
+ * rendered again, see IncrementalReader and IncrementalWriter. The centers,
+ * --path and --clusters apply as they do to a single run.
+ */
+int watch( string_view xmlFileName, string_view dotFileName, const vector<EntityPattern> &centers, unsigned depth, Adjacency::Direction direction,
+           const string &pathSource, const string &pathTarget, size_t pathLimit, bool clustering, Components::Kind clusterKind, unsigned threads,
+           unsigned printThreads ) {
+    Graph graph;
+    IncrementalReader reader( graph, threads );
+    IncrementalWriter writer{string{dotFileName}};
+    FileWatcher watcher{string{xmlFileName}};
+
+    for ( ;; ) {
+        auto start = chrono::steady_clock::now();
+        if ( !reader.read( xmlFileName.data() ) ) {
+            cout << reader.error() << endl;
+        } else if ( !reader.changed() ) {
+            cout << "No changes to the metadata" << endl;
+        } else {
+            graph.resolve();
+
+            // Nothing is written while a --path end is missing from the metadata --
+
+            bool found = true;
+            if ( !pathSource.empty() ) {
+                found = keep_paths( graph, pathSource, pathTarget, direction, pathLimit );
+            } else if ( !centers.empty() ) {
+                graph.removeAllEntitiesNotRelatedTo( centers, depth, direction );
+            }
+            if ( found ) {
+                graph.create_arrows();
+                if ( clustering ) {
+                    graph.create_clusters( clusterKind );
+                }
 
-                if ( element.find( "esas.Dynamics.Models.Contracts." ) != string::npos ) {
-                    cout << "[ERROR]: found a non converted model => " << element << " skipping.." << endl;
-                } else {
-                    newNode = key + " -> " + element;
-                    elements.push_back( newNode );
+                if ( !writer.write( graph, printThreads ) ) {
+                    cout << writer.error() << endl;
+                    return 1;
                 }
+
+                auto milliseconds = chrono::duration_cast<chrono::milliseconds>( chrono::steady_clock::now() - start ).count();
+                cout << ( writer.patched() ? "Patched " : "Updated " ) << dotFileName << " in " << milliseconds << " ms, parsed "
+                     << reader.parsedCount() << " of " << reader.chunkCount() << " chunks" << endl;
             }
         }
-    }
 
-    void print_graph( ostream &stream ) {
+        cout << "Watching " << path( xmlFileName ).native() << " for changes ..." << endl;
+        watcher.wait();
+    }
+}
 
-        stream << "digraph Data {" << endl;
+/**
+ * --partition: writes the parts next to the output, ER.dot giving ER_1.dot,
+ * ER_2.dot, ..., then an overview of them to stream, one node per part
+ * linked to its file, and the same list as text to ER_index.txt.
+ */
+bool print_partitions( Graph &graph, ostream &stream, const path &output, uint32_t maxSize, unsigned threads ) {
+    auto sibling = [&]( const string &suffix ) { return ( output.parent_path() / ( output.stem().string() + suffix ) ).string(); };
+    auto part_name = [&]( size_t part ) { return sibling( "_" + to_string( part ) + output.extension().string() ); };
+    auto indexFileName = sibling( "_index.txt" );
+
+    auto parts = graph.print_communities( maxSize, part_name, threads );
+    if ( parts.empty() ) {
+        return false;
+    }
 
-        for ( const auto &i : elements ) {
-            stream << i << endl;
+    ofstream index( indexFileName );
+    stream << "digraph Parts {\n";
+    size_t written = 0;
+    for ( size_t i = 0; i < parts.size(); ++i ) {
+        const auto &part = parts[i];
+        if ( part.tables == 0 ) {
+            continue;
         }
+        auto file = path( part.fileName ).filename().string();
+        index << file << "\t" << part.tables << " entities\t" << part.arrows << " arrows\t" << part.stubs << " stubs\n";
+        stream << "part_" << i << " [shape=box fontname=Helvetica label=\"" << file << "\\n" << part.tables << " entities\" URL=\"" << file << "\"];\n";
+        for ( const auto &link : part.links ) {
+            stream << "part_" << i << " -> part_" << link.first << " [label=\"" << link.second << "\"];\n";
+        }
+        ++written;
+    }
+    stream << "}\n";
+    cout << "Wrote " << written << " parts as " << part_name( 1 ) << " and so on, listed in " << indexFileName << endl;
+    return static_cast<bool>( index );
+}
 
-        stream << "}" << endl;
+void report( const Stats &measurements, bool stats, string_view statsJsonFileName ) {
+    if ( stats ) {
+        measurements.print( cout );
+    }
+    if ( !statsJsonFileName.empty() ) {
+        ofstream json( statsJsonFileName.data() );
+        measurements.print_json( json );
     }
+}
 
-    map<string, string> find_all_properties( const XMLElement *element, const string &name ) {
-        map<string, string> properties;
-        for ( const XMLElement *child = element->FirstChildElement(); child != nullptr; child = child->NextSiblingElement() ) {
+auto main( int argc, char **argv ) -> int {
 
-            if ( child->Name() == EDMPropertyType::Property ) {
-                properties[child->Attribute( EDMAttributeType::Name.data() )] = child->Attribute( EDMAttributeType::Type.data() );
+    vector<string_view> arguments;
+    bool streaming = false; // Read the metadata with the streaming reader instead of building a DOM
+    bool mapped = false;    // Map the metadata file and parse it in place instead of reading a copy
+    bool parallel = false;  // Parse the EntityTypes in chunks and render the output on several threads
+    unsigned threads = thread::hardware_concurrency();
+    bool stats = false;     // Print phase timings and memory figures
+    string_view statsJsonFileName;
+    string_view snapshotDirectory; // Keep model snapshots here and reuse them while the metadata is unchanged
+    string_view cacheDirectory;    // Keep finished diagrams here and hand them out again for the same input
+    uint64_t cacheBytes = 512ull * 1024 * 1024;
+    bool watching = false; // Render again whenever the metadata changes
+    bool clustering = false; // Group the tables into subgraph clusters
+    auto clusterKind = Components::Kind::Strong;
+    bool splitting = false; // Also write every connected part of the diagram to a file of its own
+    bool partitioning = false; // Write communities of entities to files of their own and an overview of them
+    uint32_t partitionSize = 300;
+    string_view beforeFileName;   // Render the changes since this version of the metadata
+    string_view diffJsonFileName; // and write them as JSON here
+    unsigned depth = 1;           // Keep the entities this many edges away from the center entity
+    string pathSource;            // Keep only the shortest paths from here
+    string pathTarget;            // to here
+    size_t pathLimit = 0;         // Keep only this many of them, 0 for all
+    auto direction = Adjacency::Direction::Both;
+
+    for ( int i = 1; i < argc; ++i ) {
+        auto argument = string_view{argv[i]};
+        if ( argument == "--stream" ) {
+            streaming = true;
+        } else if ( argument == "--mmap" ) {
+            mapped = true;
+        } else if ( argument == "--parallel" ) {
+            parallel = true;
+        } else if ( argument == "--threads" && i + 1 < argc ) {
+            parallel = true;
+            threads = static_cast<unsigned>( max( 1, atoi( argv[++i] ) ) );
+        } else if ( argument == "--stats" ) {
+            stats = true;
+        } else if ( argument == "--stats-json" && i + 1 < argc ) {
+            statsJsonFileName = argv[++i];
+        } else if ( argument == "--snapshot" && i + 1 < argc ) {
+            snapshotDirectory = argv[++i];
+        } else if ( argument == "--watch" ) {
+            watching = true;
+        } else if ( argument == "--depth" && i + 1 < argc ) {
+            auto value = string_view{argv[++i]};
+            auto [end, error] = from_chars( value.data(), value.data() + value.size(), depth );
+            if ( value.empty() || error != errc{} || end != value.data() + value.size() ) {
+                cout << "Invalid depth " << value << ", expected a number of edges" << endl;
+                return 1;
             }
-
-            if ( child->Name() == EDMPropertyType::NavigationProperty ) {
-
-                string type = child->Attribute( EDMAttributeType::Type.data() );
-                for ( const XMLElement *innerchild = child->FirstChildElement(); innerchild != nullptr; innerchild = innerchild->NextSiblingElement() ) {
-                    if ( innerchild->Name() == EDMPropertyType::ReferentialConstraint ) {
-
-                        string key{innerchild->Attribute( EDMAttributeType::Property.data() )};
-                        string value{innerchild->Attribute( EDMAttributeType::ReferencedProperty.data() )};
-
-                        string dest = type;
-                        regex e{".*\\.(.+)$"};
-                        if ( regex_match( dest, e ) ) {
-                            dest = regex_replace( dest, e, "$1" );
-                        }
-
-                        associations[name + ":" + key].push_back( dest + ":" + value );
-                    }
-                }
+        } else if ( argument == "--direction" && i + 1 < argc ) {
+            auto value = string_view{argv[++i]};
+            if ( value != "out" && value != "in" && value != "both" ) {
+                cout << "Invalid direction " << value << ", expected out, in or both" << endl;
+                return 1;
+            }
+            direction = value == "out" ? Adjacency::Direction::Out : value == "in" ? Adjacency::Direction::In : Adjacency::Direction::Both;
+        } else if ( argument == "--path" && i + 2 < argc ) {
+            pathSource = argv[++i];
+            pathTarget = argv[++i];
+        } else if ( argument == "--paths" && i + 1 < argc ) {
+            auto value = string_view{argv[++i]};
+            auto [end, error] = from_chars( value.data(), value.data() + value.size(), pathLimit );
+            if ( value.empty() || error != errc{} || end != value.data() + value.size() ) {
+                cout << "Invalid number of paths " << value << endl;
+                return 1;
             }
+        } else if ( argument == "--clusters" && i + 1 < argc ) {
+            auto value = string_view{argv[++i]};
+            if ( value != "scc" && value != "wcc" ) {
+                cout << "Invalid cluster kind " << value << ", expected scc or wcc" << endl;
+                return 1;
+            }
+            clustering = true;
+            clusterKind = value == "wcc" ? Components::Kind::Weak : Components::Kind::Strong;
+        } else if ( argument == "--split" ) {
+            splitting = true;
+        } else if ( argument == "--partition" ) {
+            partitioning = true;
+        } else if ( argument == "--partition-size" && i + 1 < argc ) {
+            partitioning = true;
+            partitionSize = static_cast<uint32_t>( max( 1, atoi( argv[++i] ) ) );
+        } else if ( argument == "--diff" && i + 1 < argc ) {
+            beforeFileName = argv[++i];
+        } else if ( argument == "--diff-json" && i + 1 < argc ) {
+            diffJsonFileName = argv[++i];
+        } else if ( argument == "--cache" && i + 1 < argc ) {
+            cacheDirectory = argv[++i];
+        } else if ( argument == "--cache-size" && i + 1 < argc ) {
+            cacheBytes = strtoull( argv[++i], nullptr, 10 ) * 1024 * 1024;
+        } else {
+            arguments.push_back( argument );
         }
+    }
 
-        return properties;
+    if ( arguments.size() < 2 ) {
+        cout << "Usage: prg [--stream | --mmap | --parallel] [--threads <n>] [--stats] [--stats-json <file>] [--snapshot <dir>] [--cache <dir>] [--cache-size <MB>] [--depth <n>] [--direction out|in|both] [--path <source> <target>] [--paths <k>] [--clusters scc|wcc] [--split] [--partition] [--partition-size <n>] [--watch] [--diff <old metadata file>] [--diff-json <file>] <metadata file> <output dot file> [<starting entities, patterns or /regex/, comma separated> ...]" << endl;
+        return 1;
     }
 
-    void visit( const XMLElement *root ) {
-        for ( const XMLElement *child = root->FirstChildElement(); child != nullptr; child = child->NextSiblingElement() ) {
-            if ( child->Name() == EDMPropertyType::EntityType ) {
-                auto name = child->Attribute( EDMAttributeType::Name.data() );
-                auto properties = find_all_properties( child, name );
-                add_table( name, properties );
-            }
+    auto xmlFileName = arguments[0]; // Input file
+    auto dotFileName = arguments[1]; // Output file
+    string centerEntity{}; // Middle entities of graph, only include entities related to these
+    vector<EntityPattern> centers;
+    for ( size_t i = 2; i < arguments.size(); ++i ) {
+        string error;
+        if ( !EntityPattern::parse_list( arguments[i], centers, error ) ) {
+            cout << error << endl;
+            return 1;
+        }
+        append_to_string( centerEntity, centerEntity.empty() ? "" : ",", arguments[i] );
+    }
+    if ( !pathSource.empty() && !centers.empty() ) {
+        cout << "--path can't be combined with center entities, it picks its own" << endl;
+        return 1;
+    }
 
-            if ( child->Name() == EDMPropertyType::EntitySet ) {
-                auto name = child->Attribute( EDMAttributeType::Name.data() );
-                auto type = child->Attribute( EDMAttributeType::EntityType.data() );
-                add_entity( name, type );
+    if ( watching ) {
+
+        // Everything else writes other files or reads the metadata its own way, once --
+
+        const pair<bool, const char *> unsupported[] = {{streaming, "--stream"},
+                                                        {mapped, "--mmap"},
+                                                        {stats, "--stats"},
+                                                        {!statsJsonFileName.empty(), "--stats-json"},
+                                                        {!snapshotDirectory.empty(), "--snapshot"},
+                                                        {!cacheDirectory.empty(), "--cache"},
+                                                        {splitting, "--split"},
+                                                        {partitioning, "--partition"},
+                                                        {!beforeFileName.empty(), "--diff"}};
+        for ( const auto &[given, option] : unsupported ) {
+            if ( given ) {
+                cout << option << " can't be used with --watch" << endl;
+                return 1;
             }
-
-            visit( child );
         }
+        return watch( xmlFileName, dotFileName, centers, depth, direction, pathSource, pathTarget, pathLimit, clustering, clusterKind, threads,
+                      parallel ? threads : 1 );
     }
 
-    void removeAllEntitiesNotRelatedTo( string centerEntity ) {
+    Stats measurements;
+    if ( !beforeFileName.empty() ) {
+        int result = diff( beforeFileName, xmlFileName, dotFileName, diffJsonFileName, parallel ? threads : 1, measurements );
+        report( measurements, stats, statsJsonFileName );
+        return result;
+    }
 
-        vector<string> relatedEnteties{centerEntity};
+    Graph graph;
 
-        for ( auto &[sourceField, targetFields] : associations ) {
+    // Snapshots and cached diagrams are both found by the hash of the metadata --
 
-            // Keep all relations going out of the center entity --
+    uint64_t inputHash = 0;
+    if ( !snapshotDirectory.empty() || !cacheDirectory.empty() ) {
+        MappedFile input;
+        if ( input.open( xmlFileName.data() ) ) {
+            auto timer = measurements.phase( "hash" );
+            inputHash = content_hash( input.data(), input.size() );
+        } else {
+            snapshotDirectory = cacheDirectory = {};
+        }
+    }
 
-            if ( sourceField.rfind( centerEntity + ":", 0 ) == 0 ) {
-                for ( const auto &field : targetFields ) {
-                    relatedEnteties.emplace_back( entityFromFieldName( field ) );
-                }
-                continue;
-            }
+    // A diagram rendered before from the same input and arguments is used as is --
 
-            // Remove all relations to other entities --
+    RenderCache cache( string{cacheDirectory}, cacheBytes );
+    string filterOptions = "depth=" + to_string( depth ) + " direction=" + to_string( static_cast<int>( direction ) );
+    if ( !pathSource.empty() ) {
+        filterOptions += " path=" + to_string( pathSource.size() ) + ":" + pathSource + pathTarget + " paths=" + to_string( pathLimit );
+    }
+    if ( clustering ) {
+        filterOptions += clusterKind == Components::Kind::Weak ? " clusters=wcc" : " clusters=scc";
+    }
+    if ( splitting || partitioning ) {
+        cacheDirectory = {}; // The cache holds the one output file only
+    }
+    uint64_t cacheKey = RenderCache::key( inputHash, centerEntity, filterOptions );
+    if ( !cacheDirectory.empty() ) {
+        bool hit;
+        {
+            auto timer = measurements.phase( "cache" );
+            hit = cache.fetch( cacheKey, string{dotFileName} );
+        }
+        if ( hit ) {
+            cout << "Processing ..." << endl;
+            print_done( dotFileName );
+            measurements.count( "cache_hit", 1 );
+            report( measurements, stats, statsJsonFileName );
+            return 0;
+        }
+        if ( !cache.error().empty() ) {
+            cout << "Couldn't use render cache: " << cache.error() << endl;
+        }
+    }
 
-            targetFields.erase(
-                remove_if( targetFields.begin(), targetFields.end(), [&]( const string &field ) { return field.rfind( centerEntity + ":", 0 ) != 0; } ),
-                targetFields.end() );
+    // A snapshot of the model read from the same bytes replaces reading and resolving --
 
-            if ( targetFields.size() > 0 ) {
-                relatedEnteties.emplace_back( entityFromFieldName( sourceField ) );
-            }
-        }
+    string snapshotFileName;
+    bool fromSnapshot = false;
+    if ( !snapshotDirectory.empty() ) {
+        snapshotFileName = ModelSnapshot::file_name( string{snapshotDirectory}, inputHash );
 
-        // Delete all references that are not related to the center entity --
+        auto timer = measurements.phase( "snapshot" );
+        EDMModel model;
+        ModelSnapshot snapshot;
+        if ( snapshot.load( model, inputHash, snapshotFileName ) ) {
+            graph.assign( move( model ) );
+            fromSnapshot = true;
+        }
+    }
 
-        for ( auto it = associations.begin(); it != associations.end(); ) {
-            if ( find( relatedEnteties.begin(), relatedEnteties.end(), entityFromFieldName( it->first ) ) == relatedEnteties.end() ) {
-                it = associations.erase( it );
+    if ( fromSnapshot ) {
+        measurements.count( "snapshot_hit", 1 );
+    } else if ( parallel ) {
+        ParallelReader reader( graph, threads );
+        auto timer = measurements.phase( "read" );
+        if ( !reader.read( xmlFileName.data() ) ) {
+            cout << "Couldn't read input file " << path( xmlFileName ).native() << ": " << reader.error() << endl;
+            return 1;
+        }
+        measurements.count( "bytes_read", reader.bytesRead() );
+        measurements.count( "chunks", reader.chunkCount() );
+    } else if ( streaming ) {
+        CSDLReader reader( graph );
+        auto timer = measurements.phase( "read" );
+        if ( !reader.read( xmlFileName.data() ) ) {
+            cout << "Couldn't read input file " << path( xmlFileName ).native() << ": " << reader.error() << endl;
+            return 1;
+        }
+        measurements.count( "bytes_read", reader.bytesRead() );
+    } else {
+        auto doc = make_shared<XMLDocument>();
+        doc->SetNameClassifier( classify_edm_name );
+        {
+            auto timer = measurements.phase( "load" );
+            if ( mapped ) {
+                doc->LoadFileMapped( xmlFileName.data() );
             } else {
-                ++it;
+                doc->LoadFile( xmlFileName.data() );
             }
         }
 
-        // Delete all entities that are not related to the center entity --
+        const XMLElement *root = doc->FirstChildElement( EDMPropertyType::Edmx.data() );
+        if ( root == nullptr ) {
+            cout << "Couldn't open input file " << path( xmlFileName ).native() << endl;
+            return 1;
+        }
 
-        for ( auto it = elements.begin(); it != elements.end(); ) {
+        // Names stay in the document buffer instead of being copied into the model --
 
-            bool found = false;
-            for ( const auto &field : relatedEnteties ) {
-                found |= ( *it ).find( field ) == 0;
-            }
+        graph.borrow_from( doc );
 
-            if ( !found ) {
-                it = elements.erase( it );
-            } else {
-                ++it;
-            }
+        {
+            auto timer = measurements.phase( "visit" );
+            graph.visit( root );
         }
-    }
-
-  private:
-    vector<string> elements;
-    Associations associations;
 
-    string entityFromFieldName( string const &fieldName ) {
-        std::string::size_type pos = fieldName.find( ':' );
-        if ( pos != std::string::npos ) {
-            return fieldName.substr( 0, pos );
-        }
-        return fieldName;
+        error_code error;
+        measurements.count( "bytes_read", static_cast<size_t>( file_size( path( xmlFileName ), error ) ) );
+        measurements.count( "xml_pool_allocs", static_cast<size_t>( doc->PoolCurrentAllocs() ) );
+        measurements.count( "xml_pool_untracked", static_cast<size_t>( doc->PoolUntracked() ) );
+        measurements.count( "xml_pool_bytes", doc->PoolBytes() );
     }
-};
 
-auto main( int argc, char **argv ) -> int {
+    if ( !fromSnapshot ) {
+        {
+            auto timer = measurements.phase( "resolve" );
+            graph.resolve();
+        }
 
-    if ( argc < 3 ) {
-        cout << "Usage: prg <metadata file> <output dot file> <starting entity>" << endl;
-        return 1;
+        if ( !snapshotFileName.empty() ) {
+            auto timer = measurements.phase( "snapshot_save" );
+            ModelSnapshot snapshot;
+            error_code error;
+            create_directories( path( snapshotDirectory ), error );
+            if ( !snapshot.save( graph.model(), inputHash, snapshotFileName ) ) {
+                cout << "Couldn't save model snapshot: " << snapshot.error() << endl;
+            }
+        }
     }
 
-    auto xmlFileName = std::string_view{argv[1]}; // Input file
-    auto dotFileName = std::string_view{argv[2]}; // Output file
-    string centerEntity{};
-    if(argc>3) {
-        centerEntity = argv[3];                // Middle entity of graph, only include entities related to this
+    if ( !pathSource.empty() ) {
+        auto timer = measurements.phase( "filter" );
+        if ( !keep_paths( graph, pathSource, pathTarget, direction, pathLimit ) ) {
+            return 1;
+        }
+    } else if ( !centers.empty() ) {
+        auto timer = measurements.phase( "filter" );
+        graph.removeAllEntitiesNotRelatedTo( centers, depth, direction );
     }
 
-    XMLDocument doc;
-    doc.LoadFile( xmlFileName.data() );
-
-    const XMLElement *root = doc.FirstChildElement( EDMPropertyType::Edmx.data() );
-    if ( root == nullptr ) {
-        cout << "Couldn't open input file " << path( xmlFileName ).native() << endl;
-        return 1;
+    {
+        auto timer = measurements.phase( "arrows" );
+        graph.create_arrows();
     }
 
-    Graph graph;
-
-    graph.visit( root );
-    if(!centerEntity.empty()) {
-     graph.removeAllEntitiesNotRelatedTo( centerEntity );
+    if ( clustering ) {
+        auto timer = measurements.phase( "clusters" );
+        graph.create_clusters( clusterKind );
     }
-    graph.create_arrows();
 
-    ofstream myfile( dotFileName );
+    unlink_shared_output( dotFileName );
+    ofstream myfile( dotFileName.data() );
     if ( myfile.is_open() ) {
         cout << "Processing ..." << endl;
-        graph.print_graph( myfile );
-        cout << "Now use GraphViz to generate the diagram using fdp, dot, neato or equivalent:" << endl
-             << endl;
-        cout << "   /usr/local/bin/dot  -Tpdf " << dotFileName << "  -o /tmp/ER.pdf && open /tmp/ER.pdf" << endl
-             << endl;
-        cout << "Done." << endl;
+        if ( partitioning ) {
+            auto timer = measurements.phase( "partition" );
+            if ( !print_partitions( graph, myfile, path( dotFileName ), partitionSize, parallel ? threads : 1 ) ) {
+                cout << "Error writing the parts of " << dotFileName << endl;
+            }
+            myfile.flush();
+        } else {
+            auto timer = measurements.phase( "print" );
+            graph.print_graph( myfile, parallel ? threads : 1 );
+            myfile.flush();
+        }
+        bool written = static_cast<bool>( myfile );
         myfile.close();
+
+        // Parts go next to the output, ER.dot giving ER_1.dot, ER_2.dot, ... and ER_0.dot for lone entities --
+
+        if ( splitting ) {
+            auto timer = measurements.phase( "split" );
+            path output( dotFileName );
+            auto part_name = [&]( size_t part ) {
+                return ( output.parent_path() / ( output.stem().string() + "_" + to_string( part ) + output.extension().string() ) ).string();
+            };
+            size_t parts = graph.print_components( part_name, parallel ? threads : 1 );
+            if ( parts == 0 ) {
+                cout << "Error writing the parts of " << dotFileName << endl;
+            } else {
+                cout << "Wrote " << parts << " parts as " << part_name( 1 ) << " and so on" << endl;
+            }
+            measurements.count( "parts", parts );
+        }
+        print_done( dotFileName );
+
+        if ( written && !cacheDirectory.empty() ) {
+            auto timer = measurements.phase( "cache_store" );
+            if ( !cache.store( cacheKey, string{dotFileName} ) ) {
+                cout << "Couldn't add to render cache: " << cache.error() << endl;
+            }
+        }
     } else {
         cout << "Error writing to file!";
     }
 
+    if ( stats || !statsJsonFileName.empty() ) {
+        const auto &model = graph.model();
+        measurements.count( "entities", model.entity_count() );
+        measurements.count( "properties", model.propertyNames.size() );
+        measurements.count( "edges", model.edge_count() );
+        measurements.count( "entity_sets", model.entitySetNames.size() );
+        measurements.count( "strings", model.strings.size() );
+        measurements.count( "string_bytes_copied", model.strings.copiedBytes() );
+        measurements.count( "model_bytes", model.memoryUsage() );
+        measurements.count( "tables_written", graph.table_count() );
+        measurements.count( "arrows_written", graph.arrow_count() );
+    }
+    report( measurements, stats, statsJsonFileName );
+
     return 0;
 }
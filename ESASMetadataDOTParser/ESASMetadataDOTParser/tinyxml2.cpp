@@ -32,6 +32,14 @@ distribution.
 #   include <cstdarg>
 #endif
 
+#if !defined(_WIN32) && ( defined(__unix__) || defined(__APPLE__) )
+#   define TIXML_HAS_MMAP
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
 #if defined(_MSC_VER) && (_MSC_VER >= 1400 ) && (!defined WINCE)
 	// Microsoft Visual Studio, version 2005 and higher. Not WinCE.
 	/*int _snprintf_s(
@@ -214,18 +222,19 @@ char* StrPair::ParseText( char* p, const char* endTag, int strFlags, int* curLin
     const char  endChar = *endTag;
     size_t length = strlen( endTag );
 
-    // Inner loop of text parsing.
-    while ( *p ) {
-        if ( *p == endChar && strncmp( p, endTag, length ) == 0 ) {
+    // Inner loop of text parsing: jump from one candidate end character to the next.
+    for ( ;; ) {
+        p = const_cast<char*>( XMLUtil::FindCharOrEnd( p, endChar, curLineNumPtr ) );
+        TIXMLASSERT( p );
+        if ( !*p ) {
+            return 0;
+        }
+        if ( strncmp( p, endTag, length ) == 0 ) {
             Set( start, p, strFlags );
             return p + length;
-        } else if (*p == '\n') {
-            ++(*curLineNumPtr);
         }
         ++p;
-        TIXMLASSERT( p );
     }
-    return 0;
 }
 
 
@@ -239,10 +248,7 @@ char* StrPair::ParseName( char* p )
     }
 
     char* const start = p;
-    ++p;
-    while ( *p && XMLUtil::IsNameChar( (unsigned char) *p ) ) {
-        ++p;
-    }
+    p = const_cast<char*>( XMLUtil::SkipNameChars( p + 1 ) );
 
     Set( start, p, 0 );
     return p;
@@ -287,8 +293,9 @@ const char* StrPair::GetStr()
         _flags ^= NEEDS_FLUSH;
 
         if ( _flags ) {
-            const char* p = _start;	// the read pointer
-            char* q = _start;	// the write pointer
+            // Nothing moves before the first character that needs processing.
+            const char* p = XMLUtil::FindEntityOrNewline( _start );	// the read pointer
+            char* q = _start + ( p - _start );	// the write pointer
 
             while( p < _end ) {
                 if ( (_flags & NEEDS_NEWLINE_NORMALIZATION) && *p == CR ) {
@@ -383,6 +390,374 @@ const char* StrPair::GetStr()
 
 // --------- XMLUtil ----------- //
 
+// Scanning kernels. Every kernel stops at the null terminator. The vector
+// kernels only load a block when it cannot cross into the next page, so
+// they never fault past the end of the buffer, and take a scalar step
+// otherwise.
+
+struct ScanKernels {
+    XMLUtil::ScanKernel kernel;
+    const char* (*skipWhiteSpace)( const char* p, int* lines );
+    const char* (*findChar)( const char* p, char c, int* lines );
+    const char* (*skipName)( const char* p );
+    const char* (*findEntityOrNewline)( const char* p );
+};
+
+static const char* SkipWhiteSpaceScalar( const char* p, int* lines )
+{
+    while ( XMLUtil::IsWhiteSpace( *p ) ) {
+        if ( *p == '\n' ) {
+            ++(*lines);
+        }
+        ++p;
+    }
+    return p;
+}
+
+static const char* FindCharScalar( const char* p, char c, int* lines )
+{
+    while ( *p && *p != c ) {
+        if ( *p == '\n' ) {
+            ++(*lines);
+        }
+        ++p;
+    }
+    return p;
+}
+
+static const char* SkipNameScalar( const char* p )
+{
+    while ( *p && XMLUtil::IsNameChar( (unsigned char) *p ) ) {
+        ++p;
+    }
+    return p;
+}
+
+static const char* FindEntityOrNewlineScalar( const char* p )
+{
+    while ( *p && *p != '&' && *p != '\r' && *p != '\n' ) {
+        ++p;
+    }
+    return p;
+}
+
+static const ScanKernels scalarKernels = {
+    XMLUtil::SCAN_SCALAR, SkipWhiteSpaceScalar, FindCharScalar, SkipNameScalar, FindEntityOrNewlineScalar
+};
+
+#if ( defined(__x86_64__) || defined(__i386__) ) && ( defined(__GNUC__) || defined(__clang__) )
+#   define TIXML_HAS_SIMD_SCAN
+#   include <immintrin.h>
+
+static inline bool BlockFitsInPage( const char* p, size_t width )
+{
+    return ( reinterpret_cast<uintptr_t>( p ) & 4095 ) <= 4096 - width;
+}
+
+static inline unsigned LowBits( unsigned mask, int count )
+{
+    return count >= 32 ? mask : mask & ( ( 1u << count ) - 1 );
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static const char* SkipWhiteSpaceSSE42( const char* p, int* lines )
+{
+    const __m128i spaces = _mm_setr_epi8( ' ', '\t', '\n', '\v', '\f', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 );
+    const __m128i lf = _mm_set1_epi8( '\n' );
+    for ( ;; ) {
+        if ( !BlockFitsInPage( p, 16 ) ) {
+            if ( !XMLUtil::IsWhiteSpace( *p ) ) {
+                return p;
+            }
+            *lines += ( *p == '\n' );
+            ++p;
+            continue;
+        }
+        const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+        // Index of the first byte that is not white space; the terminator counts as such.
+        const int index = _mm_cmpistri( spaces, block, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_NEGATIVE_POLARITY );
+        const unsigned newlines = static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpeq_epi8( block, lf ) ) );
+        *lines += __builtin_popcount( LowBits( newlines, index ) );
+        if ( index < 16 ) {
+            return p + index;
+        }
+        p += 16;
+    }
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static const char* FindCharSSE42( const char* p, char c, int* lines )
+{
+    const __m128i needle = _mm_set1_epi8( c );
+    const __m128i lf = _mm_set1_epi8( '\n' );
+    const __m128i zero = _mm_setzero_si128();
+    for ( ;; ) {
+        if ( !BlockFitsInPage( p, 16 ) ) {
+            if ( !*p || *p == c ) {
+                return p;
+            }
+            *lines += ( *p == '\n' );
+            ++p;
+            continue;
+        }
+        const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+        const unsigned stops = static_cast<unsigned>( _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( block, needle ), _mm_cmpeq_epi8( block, zero ) ) ) );
+        const unsigned newlines = static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpeq_epi8( block, lf ) ) );
+        if ( stops ) {
+            const int index = __builtin_ctz( stops );
+            *lines += __builtin_popcount( LowBits( newlines, index ) );
+            return p + index;
+        }
+        *lines += __builtin_popcount( newlines );
+        p += 16;
+    }
+}
+
+__attribute__((target("sse4.2")))
+static const char* SkipNameSSE42( const char* p )
+{
+    // Name characters as byte ranges: A-Z a-z 0-9 : _ . - and everything >= 0x80.
+    const __m128i ranges = _mm_setr_epi8( 'A', 'Z', 'a', 'z', '0', '9', ':', ':', '_', '_', '.', '.', '-', '-',
+                                          static_cast<char>( 0x80 ), static_cast<char>( 0xFF ) );
+    for ( ;; ) {
+        if ( !BlockFitsInPage( p, 16 ) ) {
+            if ( !*p || !XMLUtil::IsNameChar( (unsigned char) *p ) ) {
+                return p;
+            }
+            ++p;
+            continue;
+        }
+        const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+        const int index = _mm_cmpistri( ranges, block, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY );
+        if ( index < 16 ) {
+            return p + index;
+        }
+        p += 16;
+    }
+}
+
+__attribute__((target("sse4.2")))
+static const char* FindEntityOrNewlineSSE42( const char* p )
+{
+    const __m128i specials = _mm_setr_epi8( '&', '\r', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 );
+    const __m128i zero = _mm_setzero_si128();
+    for ( ;; ) {
+        if ( !BlockFitsInPage( p, 16 ) ) {
+            if ( !*p || *p == '&' || *p == '\r' || *p == '\n' ) {
+                return p;
+            }
+            ++p;
+            continue;
+        }
+        const __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+        // Specials only match before the terminator, so check for it separately.
+        const int index = _mm_cmpistri( specials, block, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY );
+        if ( index < 16 ) {
+            return p + index;
+        }
+        const unsigned ends = static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpeq_epi8( block, zero ) ) );
+        if ( ends ) {
+            return p + __builtin_ctz( ends );
+        }
+        p += 16;
+    }
+}
+
+static const ScanKernels sse42Kernels = {
+    XMLUtil::SCAN_SSE42, SkipWhiteSpaceSSE42, FindCharSSE42, SkipNameSSE42, FindEntityOrNewlineSSE42
+};
+
+__attribute__((target("avx2")))
+static inline __m256i InRange( __m256i block, char low, char high )
+{
+    const __m256i offset = _mm256_sub_epi8( block, _mm256_set1_epi8( low ) );
+    return _mm256_cmpeq_epi8( _mm256_min_epu8( offset, _mm256_set1_epi8( static_cast<char>( high - low ) ) ), offset );
+}
+
+__attribute__((target("avx2,popcnt,bmi")))
+static const char* SkipWhiteSpaceAVX2( const char* p, int* lines )
+{
+    const __m256i space = _mm256_set1_epi8( ' ' );
+    const __m256i lf = _mm256_set1_epi8( '\n' );
+    for ( ;; ) {
+        if ( !BlockFitsInPage( p, 32 ) ) {
+            if ( !XMLUtil::IsWhiteSpace( *p ) ) {
+                return p;
+            }
+            *lines += ( *p == '\n' );
+            ++p;
+            continue;
+        }
+        const __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+        const __m256i white = _mm256_or_si256( _mm256_cmpeq_epi8( block, space ), InRange( block, '\t', '\r' ) );
+        const unsigned stops = ~static_cast<unsigned>( _mm256_movemask_epi8( white ) );
+        const unsigned newlines = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( block, lf ) ) );
+        if ( stops ) {
+            const int index = __builtin_ctz( stops );
+            *lines += __builtin_popcount( LowBits( newlines, index ) );
+            return p + index;
+        }
+        *lines += __builtin_popcount( newlines );
+        p += 32;
+    }
+}
+
+__attribute__((target("avx2,popcnt,bmi")))
+static const char* FindCharAVX2( const char* p, char c, int* lines )
+{
+    const __m256i needle = _mm256_set1_epi8( c );
+    const __m256i lf = _mm256_set1_epi8( '\n' );
+    const __m256i zero = _mm256_setzero_si256();
+    for ( ;; ) {
+        if ( !BlockFitsInPage( p, 32 ) ) {
+            if ( !*p || *p == c ) {
+                return p;
+            }
+            *lines += ( *p == '\n' );
+            ++p;
+            continue;
+        }
+        const __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+        const unsigned stops = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_or_si256( _mm256_cmpeq_epi8( block, needle ), _mm256_cmpeq_epi8( block, zero ) ) ) );
+        const unsigned newlines = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( block, lf ) ) );
+        if ( stops ) {
+            const int index = __builtin_ctz( stops );
+            *lines += __builtin_popcount( LowBits( newlines, index ) );
+            return p + index;
+        }
+        *lines += __builtin_popcount( newlines );
+        p += 32;
+    }
+}
+
+__attribute__((target("avx2,bmi")))
+static const char* SkipNameAVX2( const char* p )
+{
+    const __m256i caseBit = _mm256_set1_epi8( 0x20 );
+    for ( ;; ) {
+        if ( !BlockFitsInPage( p, 32 ) ) {
+            if ( !*p || !XMLUtil::IsNameChar( (unsigned char) *p ) ) {
+                return p;
+            }
+            ++p;
+            continue;
+        }
+        const __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+        __m256i name = InRange( _mm256_or_si256( block, caseBit ), 'a', 'z' );
+        name = _mm256_or_si256( name, InRange( block, '0', '9' ) );
+        name = _mm256_or_si256( name, _mm256_cmpeq_epi8( block, _mm256_set1_epi8( ':' ) ) );
+        name = _mm256_or_si256( name, _mm256_cmpeq_epi8( block, _mm256_set1_epi8( '_' ) ) );
+        name = _mm256_or_si256( name, InRange( block, '-', '.' ) );
+        // Bytes >= 0x80 are name characters; their sign bit is set.
+        const unsigned names = static_cast<unsigned>( _mm256_movemask_epi8( name ) ) | static_cast<unsigned>( _mm256_movemask_epi8( block ) );
+        const unsigned stops = ~names;
+        if ( stops ) {
+            return p + __builtin_ctz( stops );
+        }
+        p += 32;
+    }
+}
+
+__attribute__((target("avx2,bmi")))
+static const char* FindEntityOrNewlineAVX2( const char* p )
+{
+    const __m256i amp = _mm256_set1_epi8( '&' );
+    const __m256i zero = _mm256_setzero_si256();
+    for ( ;; ) {
+        if ( !BlockFitsInPage( p, 32 ) ) {
+            if ( !*p || *p == '&' || *p == '\r' || *p == '\n' ) {
+                return p;
+            }
+            ++p;
+            continue;
+        }
+        const __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+        __m256i special = _mm256_or_si256( _mm256_cmpeq_epi8( block, amp ), _mm256_cmpeq_epi8( block, zero ) );
+        special = _mm256_or_si256( special, InRange( block, '\n', '\r' ) );
+        const unsigned stops = static_cast<unsigned>( _mm256_movemask_epi8( special ) );
+        if ( stops ) {
+            const char* q = p + __builtin_ctz( stops );
+            // The range also caught VT and FF; step over those.
+            if ( *q == '\v' || *q == '\f' ) {
+                p = q + 1;
+                continue;
+            }
+            return q;
+        }
+        p += 32;
+    }
+}
+
+static const ScanKernels avx2Kernels = {
+    XMLUtil::SCAN_AVX2, SkipWhiteSpaceAVX2, FindCharAVX2, SkipNameAVX2, FindEntityOrNewlineAVX2
+};
+#endif
+
+static const ScanKernels* scanKernels = &scalarKernels;
+static const XMLUtil::ScanKernel detectedScanKernel = XMLUtil::SetScanKernel( XMLUtil::SCAN_AUTO );
+
+XMLUtil::ScanKernel XMLUtil::SetScanKernel( ScanKernel kernel )
+{
+    scanKernels = &scalarKernels;
+#ifdef TIXML_HAS_SIMD_SCAN
+    __builtin_cpu_init();
+    const bool hasAVX2 = __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "bmi" ) && __builtin_cpu_supports( "popcnt" );
+    const bool hasSSE42 = __builtin_cpu_supports( "sse4.2" ) && __builtin_cpu_supports( "popcnt" );
+    if ( ( kernel == SCAN_AUTO || kernel == SCAN_AVX2 ) && hasAVX2 ) {
+        scanKernels = &avx2Kernels;
+    }
+    else if ( kernel != SCAN_SCALAR && hasSSE42 ) {
+        scanKernels = &sse42Kernels;
+    }
+#else
+    (void)kernel;
+#endif
+    return scanKernels->kernel;
+}
+
+XMLUtil::ScanKernel XMLUtil::GetScanKernel()
+{
+    (void)detectedScanKernel;
+    return scanKernels->kernel;
+}
+
+const char* XMLUtil::ScanKernelName( ScanKernel kernel )
+{
+    switch ( kernel ) {
+        case SCAN_AUTO:     return "auto";
+        case SCAN_SCALAR:   return "scalar";
+        case SCAN_SSE42:    return "sse4.2";
+        case SCAN_AVX2:     return "avx2";
+    }
+    return "unknown";
+}
+
+const char* XMLUtil::SkipWhiteSpaceRun( const char* p, int* curLineNumPtr )
+{
+    int lines = 0;
+    p = scanKernels->skipWhiteSpace( p, &lines );
+    if ( curLineNumPtr ) {
+        *curLineNumPtr += lines;
+    }
+    return p;
+}
+
+const char* XMLUtil::FindCharOrEnd( const char* p, char c, int* curLineNumPtr )
+{
+    TIXMLASSERT( curLineNumPtr );
+    return scanKernels->findChar( p, c, curLineNumPtr );
+}
+
+const char* XMLUtil::SkipNameChars( const char* p )
+{
+    return scanKernels->skipName( p );
+}
+
+const char* XMLUtil::FindEntityOrNewline( const char* p )
+{
+    return scanKernels->findEntityOrNewline( p );
+}
+
 const char* XMLUtil::writeBoolTrue  = "true";
 const char* XMLUtil::writeBoolFalse = "false";
 
@@ -1389,13 +1764,17 @@ const char* XMLAttribute::Value() const
     return _value.GetStr();
 }
 
-char* XMLAttribute::ParseDeep( char* p, bool processEntities, int* curLineNumPtr )
+char* XMLAttribute::ParseDeep( char* p, bool processEntities, int* curLineNumPtr, XMLNameClassifier classifier )
 {
     // Parse using the name rules: bug fix, was using ParseText before
+    char* const nameStart = p;
     p = _name.ParseName( p );
     if ( !p || !*p ) {
         return 0;
     }
+    if ( classifier ) {
+        _nameId = classifier( nameStart, static_cast<size_t>( p - nameStart ) );
+    }
 
     // Skip white space before =
     p = XMLUtil::SkipWhiteSpace( p, curLineNumPtr );
@@ -1548,6 +1927,7 @@ void XMLAttribute::SetAttribute( float v )
 // --------- XMLElement ---------- //
 XMLElement::XMLElement( XMLDocument* doc ) : XMLNode( doc ),
     _closingType( OPEN ),
+    _nameId( 0 ),
     _rootAttribute( 0 )
 {
 }
@@ -1574,6 +1954,17 @@ const XMLAttribute* XMLElement::FindAttribute( const char* name ) const
 }
 
 
+const XMLAttribute* XMLElement::FindAttribute( int nameId ) const
+{
+    for( XMLAttribute* a = _rootAttribute; a; a = a->_next ) {
+        if ( a->_nameId == nameId ) {
+            return a;
+        }
+    }
+    return 0;
+}
+
+
 const char* XMLElement::Attribute( const char* name, const char* value ) const
 {
     const XMLAttribute* a = FindAttribute( name );
@@ -1916,7 +2307,7 @@ char* XMLElement::ParseAttributes( char* p, int* curLineNumPtr )
 
             const int attrLineNum = attrib->_parseLineNum;
 
-            p = attrib->ParseDeep( p, _document->ProcessEntities(), curLineNumPtr );
+            p = attrib->ParseDeep( p, _document->ProcessEntities(), curLineNumPtr, _document->_nameClassifier );
             if ( !p || Attribute( attrib->Name() ) ) {
                 DeleteAttribute( attrib );
                 _document->SetError( XML_ERROR_PARSING_ATTRIBUTE, attrLineNum, "XMLElement name=%s", Name() );
@@ -2025,10 +2416,14 @@ char* XMLElement::ParseDeep( char* p, StrPair* parentEndTag, int* curLineNumPtr
         ++p;
     }
 
+    char* const nameStart = p;
     p = _value.ParseName( p );
     if ( _value.Empty() ) {
         return 0;
     }
+    if ( _document->_nameClassifier ) {
+        _nameId = _document->_nameClassifier( nameStart, static_cast<size_t>( p - nameStart ) );
+    }
 
     p = ParseAttributes( p, curLineNumPtr );
     if ( !p || !*p || _closingType != OPEN ) {
@@ -2129,6 +2524,10 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
     _errorStr(),
     _errorLineNum( 0 ),
     _charBuffer( 0 ),
+    _charBufferOwnership( OWNED_BUFFER ),
+    _charBufferLength( 0 ),
+    _nameClassifier( 0 ),
+    _charBufferMapLength( 0 ),
     _parseCurLineNum( 0 ),
 	_parsingDepth(0),
     _unlinked(),
@@ -2148,6 +2547,27 @@ XMLDocument::~XMLDocument()
 }
 
 
+int XMLDocument::PoolCurrentAllocs() const
+{
+    return _elementPool.CurrentAllocs() + _attributePool.CurrentAllocs() + _textPool.CurrentAllocs() + _commentPool.CurrentAllocs();
+}
+
+
+int XMLDocument::PoolUntracked() const
+{
+    return _elementPool.Untracked() + _attributePool.Untracked() + _textPool.Untracked() + _commentPool.Untracked();
+}
+
+
+size_t XMLDocument::PoolBytes() const
+{
+    return static_cast<size_t>( _elementPool.CurrentAllocs() ) * _elementPool.ItemSize()
+         + static_cast<size_t>( _attributePool.CurrentAllocs() ) * _attributePool.ItemSize()
+         + static_cast<size_t>( _textPool.CurrentAllocs() ) * _textPool.ItemSize()
+         + static_cast<size_t>( _commentPool.CurrentAllocs() ) * _commentPool.ItemSize();
+}
+
+
 void XMLDocument::MarkInUse(const XMLNode* const node)
 {
 	TIXMLASSERT(node);
@@ -2173,8 +2593,7 @@ void XMLDocument::Clear()
 #endif
     ClearError();
 
-    delete [] _charBuffer;
-    _charBuffer = 0;
+    ReleaseCharBuffer();
 	_parsingDepth = 0;
 
 #if 0
@@ -2195,6 +2614,29 @@ void XMLDocument::Clear()
 }
 
 
+void XMLDocument::ReleaseCharBuffer()
+{
+    switch ( _charBufferOwnership ) {
+        case OWNED_BUFFER:
+            delete [] _charBuffer;
+            break;
+        case MAPPED_BUFFER:
+#ifdef TIXML_HAS_MMAP
+            if ( _charBuffer ) {
+                munmap( _charBuffer, _charBufferMapLength );
+            }
+#endif
+            break;
+        case BORROWED_BUFFER:
+            break;
+    }
+    _charBuffer = 0;
+    _charBufferOwnership = OWNED_BUFFER;
+    _charBufferLength = 0;
+    _charBufferMapLength = 0;
+}
+
+
 void XMLDocument::DeepCopy(XMLDocument* target) const
 {
 	TIXMLASSERT(target);
@@ -2348,12 +2790,78 @@ XMLError XMLDocument::LoadFile( FILE* fp )
     }
 
     _charBuffer[size] = 0;
+    _charBufferLength = size;
 
     Parse();
     return _errorID;
 }
 
 
+XMLError XMLDocument::LoadFileMapped( const char* filename )
+{
+    if ( !filename ) {
+        TIXMLASSERT( false );
+        SetError( XML_ERROR_FILE_COULD_NOT_BE_OPENED, 0, "filename=<null>" );
+        return _errorID;
+    }
+
+#ifdef TIXML_HAS_MMAP
+    Clear();
+    const int fd = open( filename, O_RDONLY );
+    if ( fd < 0 ) {
+        SetError( XML_ERROR_FILE_NOT_FOUND, 0, "filename=%s", filename );
+        return _errorID;
+    }
+
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 || !S_ISREG( info.st_mode ) ) {
+        close( fd );
+        return LoadFile( filename );
+    }
+    if ( info.st_size == 0 ) {
+        close( fd );
+        SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
+        return _errorID;
+    }
+
+    // Reserve room for the file plus at least one byte, rounded up to whole
+    // pages, then map the file over the start of it. Bytes past the end of
+    // the file read as zero, which gives the parser its null terminator
+    // without copying the file.
+    const size_t size = static_cast<size_t>( info.st_size );
+    const size_t pageSize = static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+    const size_t mapLength = ( size / pageSize + 1 ) * pageSize;
+
+    void* region = mmap( 0, mapLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+    if ( region == MAP_FAILED ) {
+        close( fd );
+        return LoadFile( filename );
+    }
+    void* mapped = mmap( region, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0 );
+    close( fd );
+    if ( mapped == MAP_FAILED ) {
+        munmap( region, mapLength );
+        return LoadFile( filename );
+    }
+    madvise( mapped, size, MADV_SEQUENTIAL );
+
+    _charBuffer = static_cast<char*>( mapped );
+    _charBufferOwnership = MAPPED_BUFFER;
+    _charBufferLength = size;
+    _charBufferMapLength = mapLength;
+    TIXMLASSERT( _charBuffer[size] == 0 );
+
+    Parse();
+    if ( Error() ) {
+        ClearAfterParseError();
+    }
+    return _errorID;
+#else
+    return LoadFile( filename );
+#endif
+}
+
+
 XMLError XMLDocument::SaveFile( const char* filename, bool compact )
 {
     if ( !filename ) {
@@ -2399,22 +2907,50 @@ XMLError XMLDocument::Parse( const char* p, size_t len )
     _charBuffer = new char[ len+1 ];
     memcpy( _charBuffer, p, len );
     _charBuffer[len] = 0;
+    _charBufferLength = len;
+
+    Parse();
+    if ( Error() ) {
+        ClearAfterParseError();
+    }
+    return _errorID;
+}
+
+
+XMLError XMLDocument::ParseInPlace( char* xml, size_t len )
+{
+    Clear();
+
+    if ( len == 0 || !xml || !*xml ) {
+        SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
+        return _errorID;
+    }
+    TIXMLASSERT( xml[len] == 0 );
+    _charBuffer = xml;
+    _charBufferOwnership = BORROWED_BUFFER;
+    _charBufferLength = len;
 
     Parse();
     if ( Error() ) {
-        // clean up now essentially dangling memory.
-        // and the parse fail can put objects in the
-        // pools that are dead and inaccessible.
-        DeleteChildren();
-        _elementPool.Clear();
-        _attributePool.Clear();
-        _textPool.Clear();
-        _commentPool.Clear();
+        ClearAfterParseError();
     }
     return _errorID;
 }
 
 
+void XMLDocument::ClearAfterParseError()
+{
+    // clean up now essentially dangling memory.
+    // and the parse fail can put objects in the
+    // pools that are dead and inaccessible.
+    DeleteChildren();
+    _elementPool.Clear();
+    _attributePool.Clear();
+    _textPool.Clear();
+    _commentPool.Clear();
+}
+
+
 void XMLDocument::Print( XMLPrinter* streamer ) const
 {
     if ( streamer ) {
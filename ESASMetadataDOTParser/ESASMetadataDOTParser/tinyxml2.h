@@ -124,6 +124,14 @@ class XMLDeclaration;
 class XMLUnknown;
 class XMLPrinter;
 
+/**
+	Maps an element or attribute name to a small integer id at parse
+	time, so callers can switch on NameId() instead of comparing
+	strings. Receives the raw name (not null terminated) and returns
+	0 for names it does not know.
+*/
+typedef int (*XMLNameClassifier)( const char* name, size_t length );
+
 /*
 	A class that wraps strings. Normally stores the start and end
 	pointers into the XML file itself, and will apply normalization
@@ -432,9 +440,11 @@ public:
 	//		16k:	5200
 	//		32k:	4300
 	//		64k:	4000	21000
+	// $metadata documents run to tens of MB, and 16k blocks take a quarter of
+	// the allocations of 4k at the same parse time; 64k is slower again.
     // Declared public because some compilers do not accept to use ITEMS_PER_BLOCK
     // in private part if ITEMS_PER_BLOCK is private
-    enum { ITEMS_PER_BLOCK = (4 * 1024) / ITEM_SIZE };
+    enum { ITEMS_PER_BLOCK = (16 * 1024) / ITEM_SIZE };
 
 private:
     MemPoolT( const MemPoolT& ); // not supported
@@ -553,12 +563,11 @@ public:
     static const char* SkipWhiteSpace( const char* p, int* curLineNumPtr )	{
         TIXMLASSERT( p );
 
-        while( IsWhiteSpace(*p) ) {
-            if (curLineNumPtr && *p == '\n') {
-                ++(*curLineNumPtr);
-            }
-            ++p;
+        // Most calls land on a non-space; only runs go to the scan kernels.
+        if ( !IsWhiteSpace(*p) ) {
+            return p;
         }
+        p = SkipWhiteSpaceRun( p, curLineNumPtr );
         TIXMLASSERT( p );
         return p;
     }
@@ -639,6 +648,31 @@ public:
 	// Be sure to set static const memory as parameters.
 	static void SetBoolSerialization(const char* writeTrue, const char* writeFalse);
 
+    // Byte scanning kernels used by the parser. SCAN_AUTO picks the
+    // widest kernel the CPU supports at startup; the scalar loops are
+    // always available as a fallback. Setting the kernel returns the
+    // one actually selected, which may be narrower than requested.
+    // Be careful: static, global, & not thread safe.
+    enum ScanKernel {
+        SCAN_AUTO,
+        SCAN_SCALAR,
+        SCAN_SSE42,
+        SCAN_AVX2
+    };
+    static ScanKernel SetScanKernel( ScanKernel kernel );
+    static ScanKernel GetScanKernel();
+    static const char* ScanKernelName( ScanKernel kernel );
+
+    // Skips a run of white space with the selected kernel, counting lines.
+    static const char* SkipWhiteSpaceRun( const char* p, int* curLineNumPtr );
+    // Returns the first occurrence of 'c' or the null terminator, adding
+    // the newlines passed over to *curLineNumPtr.
+    static const char* FindCharOrEnd( const char* p, char c, int* curLineNumPtr );
+    // Returns the first character after p that is not a name character.
+    static const char* SkipNameChars( const char* p );
+    // Returns the first '&', CR, LF or the null terminator.
+    static const char* FindEntityOrNewline( const char* p );
+
 private:
 	static const char* writeBoolTrue;
 	static const char* writeBoolFalse;
@@ -1149,6 +1183,9 @@ public:
     /// Gets the line number the attribute is in, if the document was parsed from a file.
     int GetLineNum() const { return _parseLineNum; }
 
+    /// The id the document's name classifier gave the name when it was parsed, or 0.
+    int NameId() const { return _nameId; }
+
     /// The next attribute in the list.
     const XMLAttribute* Next() const {
         return _next;
@@ -1239,18 +1276,19 @@ public:
 private:
     enum { BUF_SIZE = 200 };
 
-    XMLAttribute() : _name(), _value(),_parseLineNum( 0 ), _next( 0 ), _memPool( 0 ) {}
+    XMLAttribute() : _name(), _value(),_parseLineNum( 0 ), _nameId( 0 ), _next( 0 ), _memPool( 0 ) {}
     virtual ~XMLAttribute()	{}
 
     XMLAttribute( const XMLAttribute& );	// not supported
     void operator=( const XMLAttribute& );	// not supported
     void SetName( const char* name );
 
-    char* ParseDeep( char* p, bool processEntities, int* curLineNumPtr );
+    char* ParseDeep( char* p, bool processEntities, int* curLineNumPtr, XMLNameClassifier classifier );
 
     mutable StrPair _name;
     mutable StrPair _value;
     int             _parseLineNum;
+    int             _nameId;
     XMLAttribute*   _next;
     MemPool*        _memPool;
 };
@@ -1271,6 +1309,15 @@ public:
     /// Set the name of the element.
     void SetName( const char* str, bool staticMem=false )	{
         SetValue( str, staticMem );
+        _nameId = 0;
+    }
+
+    /** The id the document's name classifier gave the name when it
+    	was parsed, or 0 for unknown names and elements that were not
+    	parsed.
+    */
+    int NameId() const {
+        return _nameId;
     }
 
     virtual XMLElement* ToElement()				{
@@ -1515,6 +1562,8 @@ public:
     }
     /// Query a specific attribute in the list.
     const XMLAttribute* FindAttribute( const char* name ) const;
+    /// Query a specific attribute in the list by its classified name id.
+    const XMLAttribute* FindAttribute( int nameId ) const;
 
     /** Convenience function for easy access to the text inside an element. Although easy
     	and concise, GetText() is limited compared to getting the XMLText child
@@ -1694,6 +1743,7 @@ private:
 
     enum { BUF_SIZE = 200 };
     ElementClosingType _closingType;
+    int _nameId;
     // The attribute list is ordered; there is no 'lastAttribute'
     // because the list needs to be scanned for dupes before adding
     // a new attribute.
@@ -1768,6 +1818,41 @@ public:
     */
     XMLError LoadFile( FILE* );
 
+    /**
+    	Load an XML file from disk by mapping it into memory
+    	(copy-on-write) and parsing it in place. No copy of the
+    	file is made on the heap, so memory use is the mapping
+    	plus the nodes. Falls back to LoadFile() on platforms
+    	or files (pipes, devices) that cannot be mapped.
+    	Returns XML_SUCCESS (0) on success, or
+    	an errorID.
+    */
+    XMLError LoadFileMapped( const char* filename );
+
+    /**
+    	Parse an XML document in place from a writable buffer
+    	owned by the caller. The buffer must hold 'nBytes' of
+    	XML followed by a null terminator, and must stay valid
+    	and untouched for the lifetime of the document: the
+    	parser decodes text into it and the nodes point into it.
+    	Returns XML_SUCCESS (0) on success, or
+    	an errorID.
+    */
+    XMLError ParseInPlace( char* xml, size_t nBytes );
+
+    /**
+    	The text the document was parsed from, without the null
+    	terminator. Names and values of the nodes point into it,
+    	decoded in place, for as long as the document is neither
+    	cleared nor destroyed. Null before anything is loaded.
+    */
+    const char* CharBuffer() const {
+        return _charBuffer;
+    }
+    size_t CharBufferLength() const {
+        return _charBufferLength;
+    }
+
     /**
     	Save the XML file to disk.
     	Returns XML_SUCCESS (0) on success, or
@@ -1784,6 +1869,24 @@ public:
     */
     XMLError SaveFile( FILE* fp, bool compact = false );
 
+    /**
+    	Install a classifier that assigns ids to element and attribute
+    	names while parsing. Set it before Parse() or LoadFile().
+    */
+    void SetNameClassifier( XMLNameClassifier classifier ) {
+        _nameClassifier = classifier;
+    }
+
+    /**
+    	Allocation figures of the node memory pools, summed over the
+    	element, attribute, text and comment pools: the number of items
+    	currently allocated, how many of those are not (yet) owned by the
+    	tree, and the bytes they take.
+    */
+    int PoolCurrentAllocs() const;
+    int PoolUntracked() const;
+    size_t PoolBytes() const;
+
     bool ProcessEntities() const		{
         return _processEntities;
     }
@@ -1938,6 +2041,16 @@ private:
     mutable StrPair	_errorStr;
     int             _errorLineNum;
     char*			_charBuffer;
+    // How _charBuffer was obtained, and so how Clear() releases it.
+    enum BufferOwnership {
+        OWNED_BUFFER,		// new[] by the document
+        MAPPED_BUFFER,		// mmap by LoadFileMapped(), _charBufferMapLength bytes
+        BORROWED_BUFFER		// supplied to ParseInPlace(), not released
+    };
+    BufferOwnership	_charBufferOwnership;
+    size_t			_charBufferLength;
+    XMLNameClassifier _nameClassifier;
+    size_t			_charBufferMapLength;
     int				_parseCurLineNum;
 	int				_parsingDepth;
 	// Memory tracking does add some overhead.
@@ -1956,6 +2069,8 @@ private:
 	static const char* _errorNames[XML_ERROR_COUNT];
 
     void Parse();
+    void ReleaseCharBuffer();
+    void ClearAfterParseError();
 
     void SetError( XMLError error, int lineNum, const char* format, ... );
 